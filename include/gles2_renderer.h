@@ -1,12 +1,43 @@
 #ifndef _SC_GLES2_RENDERER_H
 #define _SC_GLES2_RENDERER_H
 
+#include <stdbool.h>
+
+struct sc_color_matrix;
 struct sc_output;
+struct wlr_fbox;
 
 void gl_begin();
-void sc_renderer_load_shaders();
+/* returns false when a shader can't be built */
+bool sc_renderer_load_shaders();
+
+/* texture draws are queued and submitted, possibly reordered, on flush */
+void sc_renderer_begin();
+void sc_renderer_flush();
 
 void sc_render_texture_with_output(struct wlr_gles2_texture_attribs *texture, int sx, int sy, int w,
 			int h, enum wl_output_transform t, struct sc_output *output);
 
+/*
+ * draws the uv sub rectangle (normalized, NULL for the whole texture),
+ * clipped to a rounded rect when corner_radius is positive, through
+ * color_matrix unless it's NULL
+ */
+void sc_render_texture_region_with_output(struct wlr_gles2_texture_attribs *texture,
+			const struct wlr_fbox *uv, int sx, int sy, int w, int h,
+			enum wl_output_transform t, float alpha, float corner_radius,
+			const struct sc_color_matrix *color_matrix, struct sc_output *output);
+
+/*
+ * same as above, into a framebuffer other than the output's: an fbo of
+ * w x h projected with wlr_matrix_projection(WL_OUTPUT_TRANSFORM_NORMAL) ends
+ * up with its top row first, like the client buffers
+ */
+void sc_render_texture_region_with_projection(
+			struct wlr_gles2_texture_attribs *texture, const struct wlr_fbox *uv,
+			int sx, int sy, int w, int h, enum wl_output_transform t,
+			float alpha, float corner_radius,
+			const struct sc_color_matrix *color_matrix,
+			const float projection[static 9]);
+
 #endif
@@ -7,13 +7,59 @@
 #include <errno.h>
 #include <stdio.h>
 
-#define LOG(...) fprintf(stdout, __VA_ARGS__)
-#define ELOG(...)  fprintf(stderr, __VA_ARGS__)
+enum sc_log_level {
+	SC_LOG_ERROR,
+	SC_LOG_INFO,
+	SC_LOG_DEBUG,
+};
+
+/* records above this level are dropped at the call site */
+extern enum sc_log_level sc_log_level;
+
+/*
+ * Records go to a ring buffer, as the format pointer and the raw arguments,
+ * and are formatted when flushed: by a background thread, or by
+ * sc_log_flush. The thread calling sc_log_init is the only one writing to the
+ * ring, the others, and every thread before sc_log_init, print right away.
+ * Errors are never left in the ring: they drain it before returning.
+ */
+bool sc_log_init(enum sc_log_level level, bool background);
+void sc_log_finish(void);
+void sc_log_flush(void);
+
+/* "error", "info" or "debug" */
+bool sc_log_level_from_name(const char *name, enum sc_log_level *level);
+
+/* where each level is flushed to, stdout and stderr by default */
+void sc_log_set_output(FILE *out, FILE *err);
+
+void sc_log_write(enum sc_log_level level, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+#define SC_LOG(level, ...)                                                    \
+	do {                                                                      \
+		if ((level) <= sc_log_level) {                                        \
+			sc_log_write((level), __VA_ARGS__);                               \
+		}                                                                     \
+	} while (0)
+
+#define LOG(...) SC_LOG(SC_LOG_INFO, __VA_ARGS__)
+#define ELOG(...) SC_LOG(SC_LOG_ERROR, __VA_ARGS__)
 #ifdef DEBUG
-#define DLOG(...) fprintf(stdout, __VA_ARGS__)
+#define DLOG(...) SC_LOG(SC_LOG_DEBUG, __VA_ARGS__)
 #else
-#define DLOG(...) ()
+// compiled out, the arguments are still type checked
+#define DLOG(...)                                                             \
+	do {                                                                      \
+		if (0) {                                                              \
+			sc_log_write(SC_LOG_DEBUG, __VA_ARGS__);                          \
+		}                                                                     \
+	} while (0)
 #endif
-#define LOG_ERRNO(...)  fprintf(stderr, "Error : %s\n", strerror(errno)); fprintf(stderr, __VA_ARGS__)
+#define LOG_ERRNO(...)                                                        \
+	do {                                                                      \
+		ELOG("Error : %s\n", strerror(errno));                                \
+		ELOG(__VA_ARGS__);                                                    \
+	} while (0)
 
 #endif
@@ -0,0 +1,13 @@
+#ifndef _SC_COLOR_MATRIX_H
+#define _SC_COLOR_MATRIX_H
+
+/*
+ * Applied to the straight (not premultiplied) rgba of a surface when it is
+ * drawn: out = matrix * in + offset, clamped to [0, 1].
+ */
+struct sc_color_matrix {
+	float matrix[16]; // column major, as glUniformMatrix4fv takes it
+	float offset[4];
+};
+
+#endif
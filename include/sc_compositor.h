@@ -14,6 +14,7 @@
 #include <wlr/types/wlr_xdg_shell.h>
 
 #include "sc-layer-shell.h"
+#include "sc_keybinding.h"
 
 enum sc_cursor_mode {
 	SC_CURSOR_PASSTHROUGH,
@@ -35,6 +36,8 @@ struct sc_compositor {
 	struct sc_workspace *current_workspace;
 	struct sc_view *current_view;
 	struct wl_list workspaces;
+	/* bumped when what the outputs draw changes, not just the pixels */
+	uint32_t scene_serial;
 
 	/* seat */
 	struct wlr_seat *seat;
@@ -43,10 +46,16 @@ struct sc_compositor {
 	struct wlr_xdg_shell *xdg_shell;
 	struct wlr_layer_shell_v1 *layer_shell;
 	struct sc_layer_shell_v1 *layer_composer_shell;
+	struct wlr_screencopy_manager_v1 *screencopy_manager;
+	struct wlr_export_dmabuf_manager_v1 *export_dmabuf_manager;
 	/* inputs */
 	struct wl_list keyboards;
+	struct xkb_context *xkb_context;
+	struct wl_list keymaps; // sc_keymap, compiled once per RMLVO
+	struct sc_keybindings keybindings;
 	struct wlr_cursor *cursor;
 	struct wlr_xcursor_manager *cursor_mgr;
+	const char *cursor_image; // theme cursor shown, NULL for a client surface
 
 	/* view grab */
 	enum sc_cursor_mode cursor_mode;
@@ -55,10 +64,18 @@ struct sc_compositor {
 	struct wlr_box grab_box;
 	uint32_t resize_edges;
 
+	/* pointer motion, coalesced until the next output frame */
+	bool cursor_motion_pending;
+	uint32_t cursor_motion_time;
+
 	/* output */
 	struct wl_list outputs;
 	struct wlr_output_layout *output_layout;
 
+	/* sc_thumbnail, refreshed by the timer */
+	struct wl_list thumbnails;
+	struct wl_event_source *thumbnail_timer;
+
 	/* listeners */
 	struct wl_listener on_new_output;
 	struct wl_listener on_new_input;
@@ -5,4 +5,18 @@ void sc_compositor_setup_cursor(struct sc_compositor *compositor);
 void sc_compositor_begin_interactive(struct sc_compositor *compositor,
 									 struct sc_toplevel_view *toplevel_view,
 									 enum sc_cursor_mode mode, uint32_t edges);
+
+/*
+ * Shows the named theme cursor, unless it's already the one shown. Reset
+ * compositor->cursor_image to NULL when something else changes the image.
+ */
+void sc_compositor_cursor_set_image(struct sc_compositor *compositor,
+									const char *name);
+
+/*
+ * Delivers the pointer motion accumulated since the last call: one hit test,
+ * one motion event with the latest position. Called before every output
+ * repaint and before button and axis events, to keep them ordered.
+ */
+void sc_compositor_cursor_flush(struct sc_compositor *compositor);
 #endif
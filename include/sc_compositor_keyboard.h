@@ -1,4 +1,27 @@
 #ifndef _SC_COMPOSITOR_KEYBOARD_H
 #define _SC_COMPOSITOR_KEYBOARD_H
 
+#include <xkbcommon/xkbcommon.h>
+
+struct sc_compositor;
+
+struct sc_keymap {
+	struct wl_list link;
+	/* the names it was compiled from, NULL fields as "" */
+	char *rules, *model, *layout, *variant, *options;
+	struct xkb_keymap *keymap;
+};
+
+void sc_compositor_setup_keyboard(struct sc_compositor *compositor);
+void sc_compositor_finish_keyboard(struct sc_compositor *compositor);
+
+/*
+ * Returns the keymap for these names, compiling it on the first request only.
+ * NULL names take the defaults from the environment. The compositor keeps the
+ * reference.
+ */
+struct xkb_keymap *
+sc_compositor_keymap_get(struct sc_compositor *compositor,
+						 const struct xkb_rule_names *names);
+
 #endif
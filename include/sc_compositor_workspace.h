@@ -6,8 +6,21 @@ struct sc_toplevel_view;
 struct sc_wlr_layer_view;
 struct sc_layer_view;
 struct sc_view;
+struct sc_workspace;
 
+/* creates configuration.workspaces workspaces, the first one is shown */
 void sc_compositor_setup_workspaces(struct sc_compositor *compositor);
+
+/*
+ * Shows another workspace, in constant time apart from the few layer shell
+ * surfaces following it. The views left behind get no frame callbacks and no
+ * damage until their workspace is shown again.
+ */
+void sc_compositor_switch_workspace(struct sc_compositor *compositor,
+									struct sc_workspace *workspace);
+/* wrap around at the ends */
+void sc_compositor_switch_workspace_next(struct sc_compositor *compositor);
+void sc_compositor_switch_workspace_previous(struct sc_compositor *compositor);
 void sc_compositor_add_toplevel(struct sc_compositor *compositor,
 								struct sc_toplevel_view *view);
 void sc_compositor_add_wlr_layer(struct sc_compositor *compositor,
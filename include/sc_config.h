@@ -7,7 +7,16 @@ struct sc_configuration {
 	int display_refresh;
 	float display_scale;
 	int max_render_time;
+	int adaptive_sync; // 1 to let fullscreen views drive the refresh
+	int vrr_min_refresh; // Of the panels, in Hz, 0 turns off the LFC
 	char *shaders_path;
+	int fbo_budget; // In megabytes, 0 means unlimited
+	int corner_radius; // Of the windows, in pixels
+	float inactive_dim; // How much the unfocused windows are darkened, 0 to 1
+	char *log_level; // error, info or debug
+	int workspaces; // How many, at least 1
+	int thumbnail_rate; // Thumbnail updates per second, at most
+	char *low_latency_app_ids; // Comma separated, see sc_name_list.h
 };
 
 bool sc_load_config(const char * path);
@@ -0,0 +1,24 @@
+#ifndef _SC_DOWNSCALE_H
+#define _SC_DOWNSCALE_H
+
+#include <stddef.h>
+
+struct sc_downscale_level {
+	int width;
+	int height;
+};
+
+/*
+ * Plans a downscale of a src_w x src_h image so that it fits in
+ * max_w x max_h, keeping its aspect ratio and never scaling up. The first
+ * level is what the source is drawn at, at most 2x smaller, each following
+ * one is half the previous: bilinear filtering then averages every texel,
+ * like a mipmap chain. The last level is the final size.
+ *
+ * Returns the number of levels stored, 0 for an empty source or box.
+ */
+size_t sc_downscale_levels(int src_w, int src_h, int max_w, int max_h,
+						   struct sc_downscale_level *levels,
+						   size_t max_levels);
+
+#endif
@@ -3,15 +3,51 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wayland-util.h>
 
 struct sc_fbo {
 	int width;
 	int height;
-    GLuint framebuffer;
+	GLenum format;
+	GLuint framebuffer;
 	GLuint tex;
+
+	/* pool bookkeeping */
+	struct wl_list link;
+	size_t size;
+	bool in_use;
+	uint32_t idle_since; // ms, CLOCK_MONOTONIC, when released
 };
 
-struct sc_fbo *
-fbo_create(int w, int h);
-#endif
+struct sc_fbo_pool_stats {
+	size_t budget;
+	size_t allocated;
+	size_t in_use;
+	unsigned int count;
+	unsigned int count_in_use;
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int failures;
+};
 
+/*
+ * Pooled framebuffers, reused across frames and bucketed by
+ * (width, height, format). Acquire returns NULL when the allocation fails or
+ * doesn't fit in the budget, callers are expected to fall back.
+ */
+struct sc_fbo *sc_fbo_pool_acquire(int w, int h, GLenum format);
+void sc_fbo_pool_release(struct sc_fbo *fbo);
+
+void sc_fbo_pool_set_budget(size_t bytes);
+/*
+ * Frees the framebuffers idle for too long. Idle time is measured on the
+ * clock, any number of outputs can call it on every repaint.
+ */
+void sc_fbo_pool_frame_done();
+void sc_fbo_pool_trim(size_t max_bytes);
+void sc_fbo_pool_get_stats(struct sc_fbo_pool_stats *stats);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _SC_FRAME_TIMING_H
+#define _SC_FRAME_TIMING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* nanoseconds, on the presentation clock */
+struct sc_frame_timing {
+	int64_t last_present; // of the last frame
+	int64_t refresh;      // of the mode, the shortest frame with adaptive sync
+	int render_time;      // milliseconds kept to render, 0 renders right away
+	/* adaptive sync is on and a fullscreen view drives the refresh */
+	bool adaptive;
+};
+
+/*
+ * How long to wait before rendering the next frame, <= 0 for right away.
+ * At a fixed refresh the frame is rendered render_time before the predicted
+ * refresh. With adaptive sync the panel waits for the frame instead, and
+ * the kernel holds the flips to the shortest frame: it's rendered as soon as
+ * the content is there.
+ */
+int sc_frame_timing_delay_ms(const struct sc_frame_timing *timing,
+							 int64_t now);
+
+/* running average of the time between the frames of the content */
+int64_t sc_frame_timing_average(int64_t average, int64_t sample);
+
+/*
+ * Low framerate compensation: a frame of content slower than the longest
+ * frame the panel holds (its minimum refresh) is shown again, evenly, so
+ * that every frame stays on screen as long as the others. Returns the time
+ * between the repeats, or 0 when the content is fast enough or the range
+ * too narrow to fit an even repeat.
+ */
+int64_t sc_frame_timing_lfc_interval(int64_t content, int64_t min_frame,
+									 int64_t max_frame);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef _SC_GL_STATE_H
+#define _SC_GL_STATE_H
+
+#include <GLES2/gl2.h>
+#include <stdbool.h>
+
+/*
+ * Thin tracker of the GL state touched by the gles2 renderer, it skips the
+ * calls that wouldn't change anything. It has to be invalidated whenever
+ * something else (wlroots, skia) may have used the context.
+ */
+void sc_gl_state_invalidate();
+
+void sc_gl_use_program(GLuint program);
+void sc_gl_active_texture(GLenum unit);
+void sc_gl_bind_texture(GLenum target, GLuint tex);
+void sc_gl_bind_buffer(GLenum target, GLuint buffer);
+void sc_gl_enable_vertex_attrib_array(GLuint index);
+void sc_gl_tex_min_filter(GLenum target, GLuint tex, GLint filter);
+void sc_gl_set_blend(bool enabled);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef _SC_KEYBINDING_H
+#define _SC_KEYBINDING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xkbcommon/xkbcommon.h>
+
+#define SC_KEYBINDING_BUCKETS 64
+
+struct sc_compositor;
+
+typedef void (*sc_keybinding_action_t)(struct sc_compositor *compositor);
+
+struct sc_keybinding {
+	uint32_t modifiers;
+	xkb_keysym_t sym;
+	sc_keybinding_action_t action;
+	struct sc_keybinding *next;
+};
+
+/*
+ * Keybindings hashed by modifiers and keysym. Only the modifiers in mask take
+ * part in the match, so lock keys don't get in the way.
+ */
+struct sc_keybindings {
+	struct sc_keybinding *buckets[SC_KEYBINDING_BUCKETS];
+	uint32_t mask;
+	/* union of the bound modifiers, for the early out */
+	bool any_unmodified;
+	uint32_t used_modifiers;
+};
+
+void sc_keybindings_init(struct sc_keybindings *bindings, uint32_t mask);
+void sc_keybindings_finish(struct sc_keybindings *bindings);
+
+/* replaces the action if the combination is already bound */
+bool sc_keybindings_add(struct sc_keybindings *bindings, uint32_t modifiers,
+						xkb_keysym_t sym, sc_keybinding_action_t action);
+
+/*
+ * Tells whether any binding can match these modifiers, so the keysyms of the
+ * key don't need to be looked up at all.
+ */
+bool sc_keybindings_may_match(struct sc_keybindings *bindings,
+							  uint32_t modifiers);
+
+struct sc_keybinding *sc_keybindings_find(struct sc_keybindings *bindings,
+										  uint32_t modifiers,
+										  xkb_keysym_t sym);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _SC_LAYER_ARRANGE_H
+#define _SC_LAYER_ARRANGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wlr/util/box.h>
+
+/* same values as zwlr_layer_surface_v1_anchor */
+#define SC_LAYER_ANCHOR_TOP 1
+#define SC_LAYER_ANCHOR_BOTTOM 2
+#define SC_LAYER_ANCHOR_LEFT 4
+#define SC_LAYER_ANCHOR_RIGHT 8
+
+/* what a layer surface asked for, in its current state */
+struct sc_layer_arrange_state {
+	uint32_t anchor;
+	int32_t exclusive_zone;
+	int32_t margin_top, margin_right, margin_bottom, margin_left;
+	uint32_t desired_width, desired_height;
+};
+
+/*
+ * Places one layer surface on an output. full is the output box, usable is
+ * what the exclusive zones arranged so far left of it, and shrinks by this
+ * surface's own zone. Returns false when the surface doesn't fit, it should
+ * be closed then.
+ */
+bool sc_layer_arrange_box(const struct sc_layer_arrange_state *state,
+						  const struct wlr_box *full, struct wlr_box *usable,
+						  struct wlr_box *box);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef _SC_NAME_LIST_H
+#define _SC_NAME_LIST_H
+
+#include <stdbool.h>
+
+/*
+ * Whether name is in a comma separated list of names, as found in the
+ * configuration file. Spaces around the names are ignored and "*" matches
+ * any name. A NULL list or name matches nothing.
+ */
+bool sc_name_list_contains(const char *list, const char *name);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "sc_compositor.h"
 #include "sc_fbo.h"
+#include "sc_render_list.h"
 
 struct skia_context;
 
@@ -18,6 +19,8 @@ struct sc_output {
 	float *projection_matrix;
 
 	struct wlr_box *output_box;
+	/* what the layer surfaces' exclusive zones leave, in layout coordinates */
+	struct wlr_box usable_area;
 	int width;
 	int height;
 
@@ -33,8 +36,32 @@ struct sc_output {
 	int max_render_time; // In milliseconds
 	struct wl_event_source *repaint_timer;
 
+	/* adaptive sync, on only while a fullscreen view drives the refresh */
+	bool adaptive_sync_capable;
+	struct sc_view *content_view; // only dereferenced from its own commits
+	struct timespec last_content_commit;
+	int64_t content_interval_nsec; // averaged, 0 unknown
+	struct wl_event_source *lfc_timer;
+	/* the content view is a low latency one */
+	bool low_latency;
+
+	/* commit to present of the content view, [0] vsynced, [1] low latency */
+	bool content_pending; // committed since the last rendered frame
+	/* the content commit the frame in flight shows, matched by commit_seq */
+	bool frame_content;
+	bool frame_low_latency;
+	uint32_t frame_commit_seq;
+	struct timespec frame_content_commit;
+	uint64_t latency_frames[2];
+	int64_t latency_nsec[2];
+
 	struct sc_fbo *fbo;
 	struct skia_context *skia;
+	struct sc_render_list render_list; // of the last frame
+
+	/* repaints that drew the cursor on a plane or in the frame */
+	uint64_t cursor_hw_frames;
+	uint64_t cursor_sw_frames;
 };
 
 struct sc_view;
@@ -47,6 +74,10 @@ void sc_output_on_present(struct wl_listener *listener, void *data);
 void sc_output_add_damage_from_view(struct sc_output *output, struct sc_view *view,
 						   bool whole);
 
+/* damages the part of a box, in layout coordinates, that is on the output */
+void sc_output_add_damage_box(struct sc_output *output,
+							  const struct wlr_box *box);
+
 bool sc_output_intersect_view(struct sc_output *output, struct sc_view *view);
 
 void sc_box_from_layout_to_output(struct sc_output *output,
@@ -2,6 +2,7 @@
 #define _SC_OUTPUT_REPAINTDELAY_H
 
 struct sc_output;
+struct sc_view;
 struct wlr_output_event_present;
 
 void
@@ -10,4 +11,20 @@ sc_output_update_presentation(struct sc_output *output,
 
 int sc_output_get_ms_until_refresh(struct sc_output *output);
 
+/* the view that covers the output alone changed, NULL for none */
+void sc_output_set_content_view(struct sc_output *output,
+								struct sc_view *view);
+
+/*
+ * output->content_view committed. A low latency view gets its frame
+ * callbacks right away: it isn't throttled to the refresh, each frame shows
+ * the latest of its buffers.
+ */
+void sc_output_content_commit(struct sc_output *output);
+
+/* a frame was committed to the output, after wlr_output_commit */
+void sc_output_frame_committed(struct sc_output *output);
+
+int sc_output_lfc_timer_handler(void *data);
+
 #endif
@@ -0,0 +1,20 @@
+#ifndef _SC_PROGRAM_CACHE_H
+#define _SC_PROGRAM_CACHE_H
+
+#include <GLES2/gl2.h>
+#include <stdbool.h>
+
+/*
+ * On disk cache of linked programs, using GL_OES_get_program_binary. Entries
+ * are keyed by a hash of the driver strings and the shader sources, so a
+ * driver update or a shader change just misses. Everything is a no-op when
+ * the extension isn't there.
+ */
+bool sc_program_cache_init(void);
+
+/* returns a linked program, or 0 on a miss */
+GLuint sc_program_cache_load(const char *vert_src, const char *frag_src);
+void sc_program_cache_store(GLuint program, const char *vert_src,
+							const char *frag_src);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _SC_RENDER_LIST_H
+#define _SC_RENDER_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wlr/util/box.h>
+
+#include "sc-layer-shell.h"
+#include "sc_color_matrix.h"
+
+struct sc_view;
+struct wlr_surface;
+
+enum sc_render_item_type {
+	SC_RENDER_ITEM_SURFACE,
+	SC_RENDER_ITEM_LAYER,
+};
+
+struct sc_render_item {
+	enum sc_render_item_type type;
+	/* the key of the surface image, never dereferenced when drawing */
+	struct wlr_surface *surface;
+	/* in output buffer pixels */
+	struct wlr_box box;
+	float corner_radius;
+	bool has_color_matrix;
+	struct sc_color_matrix color_matrix;
+	/* SC_RENDER_ITEM_LAYER, a copy of the committed state */
+	struct sc_layer_v1_state layer;
+	/* where the item covers what's below, empty if anywhere is translucent */
+	struct wlr_box opaque_box;
+
+	/*
+	 * The items of a view and its children follow each other, tree is the
+	 * index of the first one and view the view at the root: frame callbacks
+	 * go to views, not items.
+	 */
+	size_t tree;
+	struct sc_view *view;
+
+	/* set by sc_render_list_cull */
+	bool occluded;
+	bool tree_visible; // on the first item of the tree only
+};
+
+/*
+ * What an output frame draws, bottom to top, snapshotted from the views
+ * before anything is drawn. Drawing reads nothing else from the scene: the
+ * views can change while a list is being drawn. The storage is kept from a
+ * frame to the next.
+ */
+struct sc_render_list {
+	struct sc_render_item *items;
+	size_t len;
+	size_t cap;
+	/* the first items are the background layer, cached apart */
+	size_t background_len;
+
+	/* the scene it was built from, see sc_compositor::scene_serial */
+	bool valid;
+	uint32_t scene_serial;
+};
+
+void sc_render_list_init(struct sc_render_list *list);
+void sc_render_list_finish(struct sc_render_list *list);
+void sc_render_list_reset(struct sc_render_list *list);
+
+/* appends a zeroed item, NULL when it can't grow */
+struct sc_render_item *sc_render_list_add(struct sc_render_list *list);
+
+/*
+ * Marks the items out of bounds or covered by the opaque boxes of the items
+ * above them, and the trees with at least one item left. The background
+ * items are cached apart and never culled.
+ */
+void sc_render_list_cull(struct sc_render_list *list,
+						 const struct wlr_box *bounds);
+
+/*
+ * After sc_render_list_cull, the view covering bounds alone above the
+ * background, or NULL.
+ */
+struct sc_view *sc_render_list_fullscreen_view(struct sc_render_list *list,
+											   const struct wlr_box *bounds);
+
+#endif
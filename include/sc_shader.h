@@ -1,6 +1,36 @@
 #ifndef _SC_SHADER_H
 #define _SC_SHADER_H
 #include <GLES2/gl2.h>
+#include <stdint.h>
+
+/*
+ * Last values uploaded. Uniforms are program state, they survive rebinds and
+ * are zeroed by the link, as is this struct.
+ */
+struct sc_shader_uniforms {
+  GLfloat proj[9];
+  GLfloat alpha;
+  GLint tex;
+  GLfloat texsize[2];
+  GLfloat texpos[2];
+  GLfloat clip_transform[4];
+  GLfloat clip_shape[3];
+};
+
+/*
+ * Features of a shader variant. Each one becomes a SC_* #define prepended to
+ * both sources, a variant only pays for what it uses.
+ */
+enum sc_shader_variant {
+  SC_SHADER_ALPHA = 1 << 0,          /* sample the alpha channel */
+  SC_SHADER_OPACITY = 1 << 1,        /* per quad opacity */
+  SC_SHADER_EXTERNAL = 1 << 2,       /* samplerExternalOES */
+  SC_SHADER_STRAIGHT_ALPHA = 1 << 3, /* texture isn't premultiplied */
+  SC_SHADER_COLOR_MATRIX = 1 << 4,   /* color_matrix and color_offset */
+  SC_SHADER_ROUNDED = 1 << 5,        /* rounded rect clip, clip_* uniforms */
+};
+
+#define SC_SHADER_VARIANT_COUNT (1 << 6)
 
 struct sc_shader {
   GLuint proj;
@@ -10,15 +40,48 @@ struct sc_shader {
   GLuint color;
   GLuint texsize;
   GLuint texpos;
+  GLuint color_matrix;
+  GLuint color_offset;
+  GLuint clip_transform;
+  GLuint clip_shape;
   GLuint pos_attrib;
   GLuint tex_attrib;
+  GLuint alpha_attrib;
   GLuint program;
+  uint32_t variant;
 
   GLuint _vert;
   GLuint _frag;
+
+  struct sc_shader_uniforms uniforms;
+};
+
+/* shaders/<name>, embedded at build time, terminated by a NULL name */
+struct sc_shader_source {
+  const char *name;
+  const char *source;
 };
 
+extern const struct sc_shader_source sc_shader_sources[];
+
+/*
+ * Sources are read from configuration.shaders_path when it's set and the
+ * file exists there, and from the embedded copy otherwise. Returns NULL if
+ * the program can't be built.
+ */
 struct sc_shader *sc_shader_create(const char *name);
-void sc_shader_begin();
+/* same, compiled with the defines of variant, a mask of sc_shader_variant */
+struct sc_shader *sc_shader_create_variant(const char *name, uint32_t variant);
+void sc_shader_begin(struct sc_shader *shader);
+
+void sc_shader_set_proj(struct sc_shader *shader, const GLfloat *matrix);
+void sc_shader_set_alpha(struct sc_shader *shader, GLfloat alpha);
+void sc_shader_set_tex(struct sc_shader *shader, GLint unit);
+void sc_shader_set_texsize(struct sc_shader *shader, GLfloat w, GLfloat h);
+void sc_shader_set_texpos(struct sc_shader *shader, GLfloat x, GLfloat y);
+void sc_shader_set_clip(struct sc_shader *shader, const GLfloat *transform,
+                        const GLfloat *shape);
+void sc_shader_set_color_matrix(struct sc_shader *shader, const GLfloat *matrix,
+                                const GLfloat *offset);
 #endif
 
@@ -1,7 +1,10 @@
 #ifndef _SC_SKIA_C_H
 #define _SC_SKIA_C_H
+#include <pixman.h>
+
 #include "sc_fbo.h"
 
+struct sc_color_matrix;
 struct sc_layer_view;
 struct sc_texture_attributes {
 	GLenum target;
@@ -11,14 +14,28 @@ struct sc_texture_attributes {
 	unsigned int height;
 };
 
+/* NULL when the fbo can't be wrapped */
 struct skia_context *skia_context_create_for_view(struct sc_fbo *fbo);
-void skia_draw(struct skia_context *skia);
+bool skia_context_set_fbo(struct skia_context *skia, struct sc_fbo *fbo);
+/* clears the frame, clipped to damage until skia_submit */
+void skia_draw(struct skia_context *skia, pixman_region32_t *damage);
+
+/*
+ * Draws the cached background into the frame and returns false. When the
+ * cache is invalid it returns true instead: the surfaces drawn until
+ * skia_background_end go into the cache.
+ */
+bool skia_background_begin(struct skia_context *skia);
+void skia_background_end(struct skia_context *skia);
+void skia_invalidate_background(struct skia_context *skia);
 void skia_submit(struct skia_context *skia);
 
 struct skia_image *skia_image_from_texture(struct skia_context *skia, struct wlr_surface *surface, struct sc_texture_attributes *texture_attributes);
 void free_skia_image(struct wlr_surface *surface);
 
-void skia_draw_surface(struct skia_context *skia, struct wlr_surface *surface, int x, int y, int w, int h);
+/* color_matrix may be NULL */
+void skia_draw_surface(struct skia_context *skia, struct wlr_surface *surface, int x, int y, int w, int h, float corner_radius,
+		const struct sc_color_matrix *color_matrix);
 void skia_draw_layer(struct skia_context *skia, struct wlr_surface *surface, struct sc_layer_v1_state *layer);
 
 #endif
\ No newline at end of file
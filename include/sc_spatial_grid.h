@@ -0,0 +1,59 @@
+#ifndef _SC_SPATIAL_GRID_H
+#define _SC_SPATIAL_GRID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wlr/util/box.h>
+
+#define SC_SPATIAL_GRID_CELL_SIZE 256
+#define SC_SPATIAL_GRID_BUCKETS 64
+
+/*
+ * Embedded in the indexed object. z orders the hits of a query, the highest
+ * comes first.
+ */
+struct sc_spatial_grid_entry {
+	struct wlr_box box;
+	uint32_t z;
+	void *data;
+
+	/* covered cells, inclusive */
+	bool indexed;
+	int cx0, cy0, cx1, cy1;
+};
+
+struct sc_spatial_grid_cell {
+	int cx, cy;
+	struct sc_spatial_grid_entry **entries;
+	size_t len;
+	size_t cap;
+	struct sc_spatial_grid_cell *next;
+};
+
+/*
+ * Uniform grid over layout coordinates. Cells are hashed, so the layout can
+ * grow in any direction, and stay allocated once created.
+ */
+struct sc_spatial_grid {
+	struct sc_spatial_grid_cell *buckets[SC_SPATIAL_GRID_BUCKETS];
+};
+
+void sc_spatial_grid_init(struct sc_spatial_grid *grid);
+void sc_spatial_grid_finish(struct sc_spatial_grid *grid);
+
+/* inserts the entry, or moves it if it's already indexed */
+bool sc_spatial_grid_update(struct sc_spatial_grid *grid,
+							struct sc_spatial_grid_entry *entry,
+							const struct wlr_box *box, uint32_t z);
+void sc_spatial_grid_remove(struct sc_spatial_grid *grid,
+							struct sc_spatial_grid_entry *entry);
+
+/*
+ * Fills hits with up to max entries whose box contains the point, highest z
+ * first. Returns how many were stored.
+ */
+size_t sc_spatial_grid_query(struct sc_spatial_grid *grid, double x, double y,
+							 struct sc_spatial_grid_entry **hits, size_t max);
+
+#endif
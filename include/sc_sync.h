@@ -0,0 +1,29 @@
+#ifndef _SC_SYNC_H
+#define _SC_SYNC_H
+
+#include <stdbool.h>
+
+struct wlr_surface;
+
+/*
+ * Explicit fences for the dmabuf client buffers, on top of the implicit ones
+ * of the kernel. When a surface commits, the pending writes of the client are
+ * exported from the dmabuf as its acquire fence; the GPU waits for it right
+ * before the surface is sampled, the CPU never does. After a frame the fence
+ * of the frame is attached to the dmabufs it read from, as their release
+ * fence. Everything is a no-op without EGL_ANDROID_native_fence_sync and the
+ * dma-buf sync file ioctls.
+ */
+bool sc_sync_init(void);
+
+/* has to be called from the surface commit handler */
+void sc_sync_surface_commit(struct wlr_surface *surface);
+
+/* before sampling the surface, once per commit at most */
+void sc_sync_surface_acquire(struct wlr_surface *surface);
+
+/* a fence signalled when the GPU is done with the frame, -1 on failure */
+int sc_sync_frame_fence(void);
+void sc_sync_surface_release(struct wlr_surface *surface, int fence_fd);
+
+#endif
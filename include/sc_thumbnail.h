@@ -0,0 +1,62 @@
+#ifndef _SC_THUMBNAIL_H
+#define _SC_THUMBNAIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+struct sc_compositor;
+struct sc_fbo;
+struct sc_view;
+struct sc_workspace;
+
+/* the box the thumbnails of the toplevels and the workspaces fit in */
+#define SC_THUMBNAIL_SIZE 256
+
+/*
+ * A downscaled copy of a toplevel or of a whole workspace, for an overview.
+ * Thumbnails are rendered at configuration.thumbnail_rate at most, and only
+ * when their source changed since the last one. The source is drawn at no
+ * more than 2x its final size and halved down from there, in pooled fbos.
+ */
+struct sc_thumbnail {
+	struct wl_list link; // sc_compositor::thumbnails
+	struct sc_compositor *compositor;
+
+	/* the source, one or the other */
+	struct sc_view *view;
+	struct sc_workspace *workspace;
+
+	int max_width, max_height;
+
+	/* NULL until rendered, top row first, the image is at its origin */
+	struct sc_fbo *fbo;
+	int width, height;
+	uint32_t content_serial;
+
+	struct {
+		/* a new image is in fbo, listeners can't destroy thumbnails */
+		struct wl_signal update;
+	} events;
+};
+
+/* after the workspaces, each one gets its thumbnail */
+void sc_compositor_setup_thumbnails(struct sc_compositor *compositor);
+
+/* fits in max_width x max_height, keeping the aspect ratio */
+struct sc_thumbnail *
+sc_thumbnail_create_for_view(struct sc_compositor *compositor,
+							 struct sc_view *view, int max_width,
+							 int max_height);
+/* the whole output layout, the windows only */
+struct sc_thumbnail *
+sc_thumbnail_create_for_workspace(struct sc_compositor *compositor,
+								  struct sc_workspace *workspace,
+								  int max_width, int max_height);
+void sc_thumbnail_destroy(struct sc_thumbnail *thumbnail);
+
+/* keeps the last image of the thumbnails of a view going away */
+void sc_thumbnails_forget_view(struct sc_compositor *compositor,
+							   struct sc_view *view);
+
+#endif
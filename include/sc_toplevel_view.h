@@ -6,6 +6,8 @@
 #include "sc_compositor.h"
 #include "sc_view.h"
 
+struct sc_thumbnail;
+
 struct sc_toplevel_view {
 	struct sc_view super;
 	struct wl_list link;
@@ -14,6 +16,16 @@ struct sc_toplevel_view {
 
 	bool moving;
 	bool resizing;
+	/* matched by configuration.low_latency_app_ids when mapped */
+	bool low_latency;
+
+	/* size configures, at most one is in flight */
+	uint32_t configure_serial; // 0 when the client caught up
+	int pending_width, pending_height;
+	int sent_width, sent_height;
+
+	/* while mapped */
+	struct sc_thumbnail *thumbnail;
 
 	/* listeners */
 	struct wl_listener on_map;
@@ -30,4 +42,11 @@ struct sc_toplevel_view *
 sc_toplevel_view_create(struct wlr_xdg_surface *xdg_surface,
 						struct sc_compositor *compositor);
 
+/*
+ * Asks the client for a new size. While a configure is waiting for its ack
+ * and commit the size is only recorded, the latest one is sent afterwards.
+ */
+void sc_toplevel_view_set_size(struct sc_toplevel_view *toplevel_view,
+							   int width, int height);
+
 #endif
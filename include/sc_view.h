@@ -4,7 +4,9 @@
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/box.h>
 
+#include "sc_color_matrix.h"
 #include "sc_output.h"
+#include "sc_spatial_grid.h"
 
 struct sc_view_impl {
 	void (*for_each_surface)(struct sc_view *view,
@@ -30,7 +32,19 @@ enum sc_view_type {
 	SC_VIEW_SCLAYER,
 };
 
+/* hit testing order, from the bottom */
+enum sc_stacking_band {
+	SC_STACKING_BACKGROUND,
+	SC_STACKING_BOTTOM,
+	SC_STACKING_TOPLEVEL,
+	SC_STACKING_POPUP,
+	SC_STACKING_SCLAYER,
+	SC_STACKING_TOP,
+	SC_STACKING_OVERLAY,
+};
+
 struct skia_image;
+struct sc_workspace;
 struct sc_view {
 	enum sc_view_type type;
 	struct wl_list link;
@@ -53,6 +67,9 @@ struct sc_view {
 	struct wl_list children;
 
 	int max_render_time; // In milliseconds
+	int corner_radius; // In pixels, 0 for square corners
+	bool has_color_matrix;
+	struct sc_color_matrix color_matrix; // of the view and its children
 
 	struct wl_listener on_surface_commit;
 	struct wl_listener on_subsurface_new;
@@ -60,6 +77,12 @@ struct sc_view {
 
 	struct sc_texture_attributes *texture_attributes;
 	struct skia_image *skia;
+	uint32_t content_serial; // bumped by every commit of its surface tree
+
+	// hit testing
+	struct sc_workspace *workspace;
+	struct sc_spatial_grid_entry index_entry;
+	uint32_t stacking_serial; // 0 until mapped, raised views get a new one
 };
 
 void sc_view_init(struct sc_view *view,  enum sc_view_type type, struct sc_view_impl *impl,
@@ -90,6 +113,19 @@ void sc_view_activate(struct sc_view *view);
 
 void sc_view_deactivate(struct sc_view *view);
 
+/* NULL draws the colors as they are */
+void sc_view_set_color_matrix(struct sc_view *view,
+							  const struct sc_color_matrix *color_matrix);
+
 void
 sc_view_get_absolute_position(struct sc_view *view, struct sc_point *p);
+
+/*
+ * Keeps the workspace spatial index in sync, it has to be called whenever
+ * the view moves, resizes, maps or unmaps. Popups follow their parent.
+ */
+void sc_view_update_index(struct sc_view *view);
+void sc_view_remove_index(struct sc_view *view);
+/* puts the view on top of its stacking band */
+void sc_view_raise(struct sc_view *view);
 #endif
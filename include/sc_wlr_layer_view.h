@@ -4,6 +4,7 @@
 #include <wlr/types/wlr_layer_shell_v1.h>
 
 #include "sc_compositor.h"
+#include "sc_layer_arrange.h"
 #include "sc_view.h"
 
 struct sc_wlr_layer_view {
@@ -12,17 +13,33 @@ struct sc_wlr_layer_view {
 
 	/* protocol surfaces */
 	struct wlr_layer_surface_v1 *layer_surface;
+	/* the workspace list it's in */
+	enum zwlr_layer_shell_v1_layer layer;
+
+	/* the state it was last arranged with, and the size sent */
+	struct sc_layer_arrange_state arranged;
+	bool configure_sent;
+	int configure_width, configure_height;
+	struct wl_event_source *close_idle; // it didn't fit the output
 
 	/* listeners */
 	struct wl_listener on_map;
 	struct wl_listener on_unmap;
 	struct wl_listener on_destroy;
-	struct wl_listener on_surface_commit;
 };
 
 struct sc_wlr_layer_view *
 sc_wlr_layer_view_create(struct wlr_layer_surface_v1 *layer_surface,
-						struct sc_compositor *compositor);
+						struct sc_compositor *compositor,
+						struct sc_output *output);
+
+/*
+ * Places the layer surfaces of the output and sends them their sizes. The
+ * result stays until a surface commits a different anchor, size, margin or
+ * zone, maps, unmaps, or the output changes.
+ */
+void sc_wlr_layer_views_arrange(struct sc_compositor *compositor,
+								struct sc_output *output);
 
 #endif
 
@@ -3,8 +3,13 @@
 
 #include <wayland-server-core.h>
 
+#include "sc_spatial_grid.h"
+
+struct sc_thumbnail;
+
 struct sc_workspace {
 	struct wl_list link;
+	int index; // from 0, in the order of compositor->workspaces
 
 	struct wl_list views_toplevel;
 	struct wl_list layers_overlay;
@@ -12,6 +17,12 @@ struct sc_workspace {
 	struct wl_list layers_bottom;
 	struct wl_list layers_background;
 	struct wl_list sc_layers;
+
+	/* every mapped view of the workspace, by layout position */
+	struct sc_spatial_grid view_index;
+	/* bumped whenever one of its views commits, moves, maps or unmaps */
+	uint32_t content_serial;
+	struct sc_thumbnail *thumbnail;
 };
 
 struct sc_workspace *sc_workspace_create();
@@ -10,6 +10,11 @@
 struct skia_context {
     sk_sp<GrDirectContext> context;
     sk_sp<SkSurface> surface;
+
+    // the wallpaper and the background layer surfaces, drawn once
+    sk_sp<SkSurface> background;
+    sk_sp<SkImage> background_image;
+    bool drawing_background;
 };
 
 struct skia_image {
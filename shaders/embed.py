@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# Generates a C table of the shader sources, so the compositor doesn't depend
+# on finding the shaders directory at runtime.
+import os
+import sys
+
+
+def c_string(text):
+    lines = []
+    for line in text.splitlines(True):
+        escaped = ''
+        for c in line.encode('utf-8'):
+            ch = chr(c)
+            if ch == '\\' or ch == '"':
+                escaped += '\\' + ch
+            elif ch == '\n':
+                escaped += '\\n'
+            elif ch == '\t':
+                escaped += '\\t'
+            elif 32 <= c < 127:
+                escaped += ch
+            else:
+                escaped += '\\%03o' % c
+        lines.append('\t\t"%s"' % escaped)
+    if not lines:
+        lines.append('\t\t""')
+    return '\n'.join(lines)
+
+
+def main():
+    output = sys.argv[1]
+    with open(output, 'w') as out:
+        out.write('/* generated by shaders/embed.py, do not edit */\n')
+        out.write('#include <stddef.h>\n\n')
+        out.write('#include "sc_shader.h"\n\n')
+        out.write('const struct sc_shader_source sc_shader_sources[] = {\n')
+        for path in sys.argv[2:]:
+            with open(path) as f:
+                source = f.read()
+            out.write('\t{\n\t\t"%s",\n' % os.path.basename(path))
+            out.write(c_string(source) + ',\n\t},\n')
+        out.write('\t{NULL, NULL},\n};\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,63 @@
+// specialized by the renderer with the SC_* defines of the shader variant
+#ifdef SC_EXTERNAL
+#extension GL_OES_EGL_image_external : require
+#endif
+
+#if defined(SC_ROUNDED) && defined(GL_FRAGMENT_PRECISION_HIGH)
+// the clip works in buffer pixels, mediump runs out of bits on big surfaces
+precision highp float;
+#else
+precision mediump float;
+#endif
+varying vec2 v_texcoord;
+#ifdef SC_EXTERNAL
+uniform samplerExternalOES tex;
+#else
+uniform sampler2D tex;
+#endif
+#ifdef SC_OPACITY
+varying float v_alpha;
+#endif
+#ifdef SC_COLOR_MATRIX
+uniform mat4 color_matrix;
+uniform vec4 color_offset;
+#endif
+#ifdef SC_ROUNDED
+// texcoord origin and texcoord to pixel scale of the clipped rect
+uniform vec4 clip_transform;
+// half width, half height and corner radius, in pixels
+uniform vec3 clip_shape;
+
+float rounded_rect_coverage() {
+	vec2 p = (v_texcoord - clip_transform.xy) * clip_transform.zw;
+	vec2 q = abs(p - clip_shape.xy) - clip_shape.xy + clip_shape.z;
+	float dist = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - clip_shape.z;
+	return clamp(0.5 - dist, 0.0, 1.0);
+}
+#endif
+
+void main() {
+#ifdef SC_ALPHA
+	vec4 color = texture2D(tex, v_texcoord);
+#ifdef SC_STRAIGHT_ALPHA
+	color.rgb *= color.a;
+#endif
+#else
+	vec4 color = vec4(texture2D(tex, v_texcoord).rgb, 1.0);
+#endif
+#ifdef SC_COLOR_MATRIX
+	// the matrix works on straight colors
+	if (color.a > 0.0) {
+		color.rgb /= color.a;
+	}
+	color = clamp(color_matrix * color + color_offset, 0.0, 1.0);
+	color.rgb *= color.a;
+#endif
+#ifdef SC_OPACITY
+	color *= v_alpha;
+#endif
+#ifdef SC_ROUNDED
+	color *= rounded_rect_coverage();
+#endif
+	gl_FragColor = color;
+}
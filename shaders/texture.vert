@@ -0,0 +1,16 @@
+// quads are batched, positions are already projected to clip space
+attribute vec2 pos;
+attribute vec2 texcoord;
+varying vec2 v_texcoord;
+#ifdef SC_OPACITY
+attribute float quad_alpha;
+varying float v_alpha;
+#endif
+
+void main() {
+	gl_Position = vec4(pos, 1.0, 1.0);
+	v_texcoord = texcoord;
+#ifdef SC_OPACITY
+	v_alpha = quad_alpha;
+#endif
+}
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "sc_compositor.h"
 #include "sc_compositor_backend.h"
+#include "sc_compositor_cursor.h"
 #include "sc_compositor_keyboard.h"
 #include "sc_keyboard.h"
 #include "sc_output.h"
@@ -40,6 +41,12 @@ compositor_backend_on_new_output(struct wl_listener *listener, void *data)
 	struct sc_output *output = sc_output_create(wlr_output, compositor);
 
 	wl_list_insert(&compositor->outputs, &output->link);
+
+	// a no-op when the scale is already loaded; the new output has no
+	// cursor image yet
+	wlr_xcursor_manager_load(compositor->cursor_mgr, wlr_output->scale);
+	compositor->cursor_image = NULL;
+	sc_compositor_cursor_set_image(compositor, "left_ptr");
 }
 
 void
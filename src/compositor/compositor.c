@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <wlr/types/wlr_data_device.h>
+#include <wlr/types/wlr_export_dmabuf_v1.h>
+#include <wlr/types/wlr_screencopy_v1.h>
 #include <wlr/types/wlr_xdg_output_v1.h>
 #include <wlr/types/wlr_xdg_decoration_v1.h>
 #include <wlr/types/wlr_compositor.h>
@@ -11,6 +13,7 @@
 #include "sc_compositor.h"
 #include "sc_compositor_backend.h"
 #include "sc_compositor_cursor.h"
+#include "sc_compositor_keyboard.h"
 #include "sc_compositor_layershell.h"
 #include "sc_compositor_rendering.h"
 #include "sc_compositor_seat.h"
@@ -18,6 +21,7 @@
 #include "sc_compositor_xdgshell.h"
 #include "sc_compositor_layercompositor.h"
 #include "sc_output.h"
+#include "sc_thumbnail.h"
 
 extern struct sc_configuration configuration;
 
@@ -60,11 +64,23 @@ sc_compositor_create()
 
 	compositor->output_manager = wlr_xdg_output_manager_v1_create(
 		compositor->wl_display, compositor->output_layout);
+
+	// both read the buffer committed to the output, which is the skia fbo
+	// composited with the cursor: nothing is rendered again for a capture.
+	// copy_with_damage frames only come with the damage we set on commit,
+	// dmabuf frames are blitted on the gpu, export_dmabuf hands out the
+	// scanout buffer itself
+	compositor->screencopy_manager =
+		wlr_screencopy_manager_v1_create(compositor->wl_display);
+	compositor->export_dmabuf_manager =
+		wlr_export_dmabuf_manager_v1_create(compositor->wl_display);
 	
 	sc_compositor_setup_seat(compositor);
 	sc_compositor_setup_cursor(compositor);
+	sc_compositor_setup_keyboard(compositor);
 	sc_compositor_setup_backend(compositor);
 	sc_compositor_setup_workspaces(compositor);
+	sc_compositor_setup_thumbnails(compositor);
 	sc_compositor_setup_xdgshell(compositor);
 	sc_compositor_setup_layershell(compositor);
 	sc_compositor_setup_layercomposershell(compositor);
@@ -73,7 +89,9 @@ sc_compositor_create()
 	// wlr_xdg_decoration_manager_v1_create(compositor->wl_display);
 	// wlr_xdg_toplevel_decoration_v1_set_mode()
 
-	sc_compositor_setup_gles2();
+	if (!sc_compositor_setup_gles2()) {
+		return NULL;
+	}
 
 	return compositor;
 }
@@ -83,6 +101,7 @@ sc_compositor_destroy()
 {
 	wl_display_destroy_clients(compositor->wl_display);
 	wl_display_destroy(compositor->wl_display);
+	sc_compositor_finish_keyboard(compositor);
 	free(compositor);
 }
 
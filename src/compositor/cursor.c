@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/types/wlr_data_device.h>
 #include <wlr/types/wlr_seat.h>
 
@@ -7,10 +8,27 @@
 #include "sc_compositor.h"
 #include "sc_compositor_cursor.h"
 #include "sc_compositor_workspace.h"
+#include "sc_config.h"
 #include "sc_output.h"
 #include "sc_toplevel_view.h"
 #include "sc_view.h"
 
+extern struct sc_configuration configuration;
+
+void
+sc_compositor_cursor_set_image(struct sc_compositor *compositor,
+							   const char *name)
+{
+	if (compositor->cursor_image != NULL &&
+		strcmp(compositor->cursor_image, name) == 0) {
+		// the outputs already show it, setting it again re-uploads it
+		return;
+	}
+	wlr_xcursor_manager_set_cursor_image(compositor->cursor_mgr, name,
+										 compositor->cursor);
+	compositor->cursor_image = name;
+}
+
 void
 sc_compositor_begin_interactive(struct sc_compositor *compositor,
 								struct sc_toplevel_view *toplevel_view,
@@ -37,59 +55,84 @@ sc_compositor_begin_interactive(struct sc_compositor *compositor,
 	compositor->grab_y = compositor->cursor->y;
 
 	compositor->resize_edges = edges;
+
+	// a new grab doesn't wait on configures a previous one left unanswered
+	toplevel_view->configure_serial = 0;
+	toplevel_view->sent_width = compositor->grab_box.width;
+	toplevel_view->sent_height = compositor->grab_box.height;
+}
+
+/* damages where the view and its popups are, as recorded in the index */
+static void
+damage_view_index_boxes(struct sc_compositor *compositor, struct sc_view *view)
+{
+	if (view->index_entry.indexed) {
+		struct sc_output *output;
+		wl_list_for_each (output, &compositor->outputs, link) {
+			sc_output_add_damage_box(output, &view->index_entry.box);
+		}
+	}
+	struct sc_view *child;
+	wl_list_for_each (child, &view->children, link) {
+		if (child->type == SC_VIEW_POPUP) {
+			damage_view_index_boxes(compositor, child);
+		}
+	}
 }
 
+/*
+ * Runs once per output frame with the coalesced motion. A move doesn't change
+ * what the surfaces look like, the old and new boxes are all there is to
+ * repaint.
+ */
 static void
 process_cursor_move(struct sc_compositor *compositor, uint32_t time)
 {
 	struct sc_view *view = (struct sc_view *) compositor->grabbed_view;
 
-	// TODO optimise this, called 2 times
-	sc_output_add_damage_from_view(view->output, view, true);
-
-	view->frame.x =
-		compositor->grab_box.x + (compositor->cursor->x - compositor->grab_x);
-	view->frame.y =
-		compositor->grab_box.y + (compositor->cursor->y - compositor->grab_y);
+	int x = compositor->grab_box.x + (compositor->cursor->x - compositor->grab_x);
+	int y = compositor->grab_box.y + (compositor->cursor->y - compositor->grab_y);
+	if (x == view->frame.x && y == view->frame.y) {
+		return;
+	}
 
-	// TODO review
-	sc_output_add_damage_from_view(view->output, view, true);
+	damage_view_index_boxes(compositor, view);
+	view->frame.x = x;
+	view->frame.y = y;
+	sc_view_update_index(view);
+	damage_view_index_boxes(compositor, view);
 }
 
 static void
 process_cursor_resize(struct sc_compositor *compositor, uint32_t time)
 {
 	struct sc_toplevel_view *toplevel = compositor->grabbed_view;
-	struct sc_view *view = (struct sc_view *) compositor->grabbed_view;
 
 	double delta_x = compositor->cursor->x - compositor->grab_x;
 	double delta_y = compositor->cursor->y - compositor->grab_y;
 
-	int new_x = compositor->grab_box.x;
-	int new_y = compositor->grab_box.y;
-
 	int new_width = compositor->grab_box.width;
 	int new_height = compositor->grab_box.height;
 
 	if (compositor->resize_edges & WLR_EDGE_TOP) {
-		new_y += delta_y;
 		new_height -= delta_y;
 	} else if (compositor->resize_edges & WLR_EDGE_BOTTOM) {
 		new_height += delta_y;
 	}
 	if (compositor->resize_edges & WLR_EDGE_LEFT) {
-		new_x += delta_x;
 		new_width -= delta_x;
 	} else if (compositor->resize_edges & WLR_EDGE_RIGHT) {
 		new_width += delta_x;
 	}
+	if (new_width < 1) {
+		new_width = 1;
+	}
+	if (new_height < 1) {
+		new_height = 1;
+	}
 
-	view->frame.x = new_x;
-	view->frame.y = new_y;
-	view->frame.width = new_width;
-	view->frame.height = new_height;
-
-	wlr_xdg_toplevel_set_size(toplevel->xdg_surface, new_width, new_height);
+	// the frame follows when the client commits the new size
+	sc_toplevel_view_set_size(toplevel, new_width, new_height);
 }
 
 static void
@@ -113,8 +156,7 @@ process_cursor_motion(struct sc_compositor *compositor, uint32_t time)
 							compositor->cursor->y, &surface, &sx, &sy);
 
 	if (!view) {
-		wlr_xcursor_manager_set_cursor_image(compositor->cursor_mgr, "left_ptr",
-											 compositor->cursor);
+		sc_compositor_cursor_set_image(compositor, "left_ptr");
 	}
 	if (view != NULL) {
 		bool focus_changed =
@@ -130,6 +172,40 @@ process_cursor_motion(struct sc_compositor *compositor, uint32_t time)
 	}
 }
 
+void
+sc_compositor_cursor_flush(struct sc_compositor *compositor)
+{
+	if (!compositor->cursor_motion_pending) {
+		return;
+	}
+	compositor->cursor_motion_pending = false;
+	process_cursor_motion(compositor, compositor->cursor_motion_time);
+	wlr_seat_pointer_notify_frame(compositor->seat);
+}
+
+/*
+ * The cursor itself moves right away, the rest waits for the frame of the
+ * output under it: a 1000Hz mouse doesn't need 1000 hit tests a second.
+ */
+static void
+cursor_motion_defer(struct sc_compositor *compositor, uint32_t time)
+{
+	compositor->cursor_motion_time = time;
+	if (compositor->cursor_motion_pending) {
+		return;
+	}
+	struct wlr_output *wlr_output = wlr_output_layout_output_at(
+		compositor->output_layout, compositor->cursor->x,
+		compositor->cursor->y);
+	if (wlr_output == NULL || !wlr_output->enabled) {
+		// nothing is going to repaint
+		process_cursor_motion(compositor, time);
+		return;
+	}
+	compositor->cursor_motion_pending = true;
+	wlr_output_schedule_frame(wlr_output);
+}
+
 static void
 compositor_cursor_motion(struct wl_listener *listener, void *data)
 {
@@ -141,7 +217,7 @@ compositor_cursor_motion(struct wl_listener *listener, void *data)
 	wlr_cursor_move(compositor->cursor, event->device, event->delta_x,
 					event->delta_y);
 
-	process_cursor_motion(compositor, event->time_msec);
+	cursor_motion_defer(compositor, event->time_msec);
 }
 
 static void
@@ -155,7 +231,7 @@ compositor_cursor_motion_absolute(struct wl_listener *listener, void *data)
 	wlr_cursor_warp_absolute(compositor->cursor, event->device, event->x,
 							 event->y);
 
-	process_cursor_motion(compositor, event->time_msec);
+	cursor_motion_defer(compositor, event->time_msec);
 }
 
 static void
@@ -166,6 +242,7 @@ compositor_cursor_button(struct wl_listener *listener, void *data)
 		wl_container_of(listener, compositor, on_cursor_button);
 	struct wlr_event_pointer_button *event = data;
 
+	sc_compositor_cursor_flush(compositor);
 	wlr_seat_pointer_notify_button(compositor->seat, event->time_msec,
 								   event->button, event->state);
 
@@ -193,6 +270,7 @@ compositor_cursor_axis(struct wl_listener *listener, void *data)
 
 	struct wlr_event_pointer_axis *event = data;
 
+	sc_compositor_cursor_flush(compositor);
 	wlr_seat_pointer_notify_axis(compositor->seat, event->time_msec,
 								 event->orientation, event->delta,
 								 event->delta_discrete, event->source);
@@ -205,6 +283,10 @@ compositor_cursor_frame(struct wl_listener *listener, void *data)
 	struct sc_compositor *compositor =
 		wl_container_of(listener, compositor, on_cursor_frame);
 
+	if (compositor->cursor_motion_pending) {
+		// the flush sends the motion together with its frame
+		return;
+	}
 	wlr_seat_pointer_notify_frame(compositor->seat);
 }
 
@@ -217,10 +299,15 @@ sc_compositor_setup_cursor(struct sc_compositor *compositor)
 	wlr_cursor_attach_output_layout(compositor->cursor,
 									compositor->output_layout);
 
+	// the themes are loaded once per scale, outputs use the configured one
 	compositor->cursor_mgr = wlr_xcursor_manager_create(NULL, 24);
 	wlr_xcursor_manager_load(compositor->cursor_mgr, 1);
-	wlr_xcursor_manager_set_cursor_image(compositor->cursor_mgr, "left_ptr",
-										 compositor->cursor);
+	if (configuration.display_scale > 0 && configuration.display_scale != 1) {
+		wlr_xcursor_manager_load(compositor->cursor_mgr,
+								 configuration.display_scale);
+	}
+	compositor->cursor_image = NULL;
+	sc_compositor_cursor_set_image(compositor, "left_ptr");
 
 	compositor->on_cursor_motion.notify = compositor_cursor_motion;
 	wl_signal_add(&compositor->cursor->events.motion,
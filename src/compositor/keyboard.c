@@ -1,6 +1,169 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <string.h>
+#include <wlr/types/wlr_keyboard.h>
 
+#include "log.h"
 #include "sc_compositor.h"
 #include "sc_compositor_keyboard.h"
+#include "sc_compositor_workspace.h"
 #include "sc_keyboard.h"
+#include "sc_toplevel_view.h"
+#include "sc_workspace.h"
+
+static void
+keybinding_quit(struct sc_compositor *compositor)
+{
+	wl_display_terminate(compositor->wl_display);
+}
+
+/*
+ * Focuses the bottom toplevel of the workspace, which raises it: pressing
+ * it again goes through all of them.
+ */
+static void
+keybinding_next_view(struct sc_compositor *compositor)
+{
+	struct sc_workspace *workspace = compositor->current_workspace;
+	struct sc_toplevel_view *toplevel;
+	wl_list_for_each_reverse (toplevel, &workspace->views_toplevel, link) {
+		if (!toplevel->super.mapped ||
+			&toplevel->super == compositor->current_view) {
+			continue;
+		}
+		sc_composer_focus_view(compositor, &toplevel->super);
+		// the pointer focus follows with the next frame
+		compositor->cursor_motion_pending = true;
+		return;
+	}
+}
+
+static void
+keybinding_workspace_next(struct sc_compositor *compositor)
+{
+	sc_compositor_switch_workspace_next(compositor);
+}
+
+static void
+keybinding_workspace_previous(struct sc_compositor *compositor)
+{
+	sc_compositor_switch_workspace_previous(compositor);
+}
+
+static const char *
+name_or_empty(const char *name)
+{
+	return name != NULL ? name : "";
+}
+
+static bool
+keymap_matches(struct sc_keymap *keymap, const struct xkb_rule_names *names)
+{
+	return strcmp(keymap->rules, name_or_empty(names->rules)) == 0 &&
+		   strcmp(keymap->model, name_or_empty(names->model)) == 0 &&
+		   strcmp(keymap->layout, name_or_empty(names->layout)) == 0 &&
+		   strcmp(keymap->variant, name_or_empty(names->variant)) == 0 &&
+		   strcmp(keymap->options, name_or_empty(names->options)) == 0;
+}
+
+static void
+keymap_destroy(struct sc_keymap *keymap)
+{
+	wl_list_remove(&keymap->link);
+	xkb_keymap_unref(keymap->keymap);
+	free(keymap->rules);
+	free(keymap->model);
+	free(keymap->layout);
+	free(keymap->variant);
+	free(keymap->options);
+	free(keymap);
+}
+
+struct xkb_keymap *
+sc_compositor_keymap_get(struct sc_compositor *compositor,
+						 const struct xkb_rule_names *names)
+{
+	struct xkb_rule_names empty = {0};
+	if (compositor->xkb_context == NULL) {
+		return NULL;
+	}
+	if (names == NULL) {
+		names = &empty;
+	}
+
+	struct sc_keymap *keymap;
+	wl_list_for_each (keymap, &compositor->keymaps, link) {
+		if (keymap_matches(keymap, names)) {
+			return keymap->keymap;
+		}
+	}
+
+	DLOG("compiling keymap rules=%s layout=%s\n", name_or_empty(names->rules),
+		 name_or_empty(names->layout));
+	struct xkb_keymap *xkb_keymap = xkb_keymap_new_from_names(
+		compositor->xkb_context, names, XKB_KEYMAP_COMPILE_NO_FLAGS);
+	if (xkb_keymap == NULL) {
+		ELOG("error: can't compile the keymap\n");
+		return NULL;
+	}
+
+	keymap = calloc(1, sizeof(struct sc_keymap));
+	if (keymap == NULL) {
+		xkb_keymap_unref(xkb_keymap);
+		return NULL;
+	}
+	keymap->keymap = xkb_keymap;
+	keymap->rules = strdup(name_or_empty(names->rules));
+	keymap->model = strdup(name_or_empty(names->model));
+	keymap->layout = strdup(name_or_empty(names->layout));
+	keymap->variant = strdup(name_or_empty(names->variant));
+	keymap->options = strdup(name_or_empty(names->options));
+	wl_list_insert(&compositor->keymaps, &keymap->link);
+	if (keymap->rules == NULL || keymap->model == NULL ||
+		keymap->layout == NULL || keymap->variant == NULL ||
+		keymap->options == NULL) {
+		keymap_destroy(keymap);
+		return NULL;
+	}
+	return xkb_keymap;
+}
+
+void
+sc_compositor_setup_keyboard(struct sc_compositor *compositor)
+{
+	wl_list_init(&compositor->keymaps);
+	compositor->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+	if (compositor->xkb_context == NULL) {
+		ELOG("error: can't create the xkb context\n");
+	}
+
+	// lock keys never take part in a match
+	sc_keybindings_init(&compositor->keybindings,
+						WLR_MODIFIER_SHIFT | WLR_MODIFIER_CTRL |
+							WLR_MODIFIER_ALT | WLR_MODIFIER_LOGO);
+	sc_keybindings_add(&compositor->keybindings, WLR_MODIFIER_ALT, XKB_KEY_q,
+					   keybinding_quit);
+	sc_keybindings_add(&compositor->keybindings, WLR_MODIFIER_ALT, XKB_KEY_F1,
+					   keybinding_next_view);
+	sc_keybindings_add(&compositor->keybindings,
+					   WLR_MODIFIER_CTRL | WLR_MODIFIER_ALT, XKB_KEY_Right,
+					   keybinding_workspace_next);
+	sc_keybindings_add(&compositor->keybindings,
+					   WLR_MODIFIER_CTRL | WLR_MODIFIER_ALT, XKB_KEY_Left,
+					   keybinding_workspace_previous);
+
+	// the first keyboard doesn't pay for the compilation
+	sc_compositor_keymap_get(compositor, NULL);
+}
+
+void
+sc_compositor_finish_keyboard(struct sc_compositor *compositor)
+{
+	struct sc_keymap *keymap, *tmp;
+	wl_list_for_each_safe (keymap, tmp, &compositor->keymaps, link) {
+		keymap_destroy(keymap);
+	}
+	sc_keybindings_finish(&compositor->keybindings);
+	xkb_context_unref(compositor->xkb_context);
+	compositor->xkb_context = NULL;
+}
@@ -1,20 +1,25 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <unistd.h>
 #include <wlr/render/gles2.h>
 #include <wlr/util/region.h>
 
 #include "gles2_renderer.h"
 #include "log.h"
 #include "sc_compositor.h"
+#include "sc_config.h"
 #include "sc_output.h"
+#include "sc_output_repaintdelay.h"
 #include "sc_toplevel_view.h"
 #include "sc_wlr_layer_view.h"
 #include "sc_layer_view.h"
 #include "sc_view.h"
 #include "sc_popup_view.h"
+#include "sc_render_list.h"
 #include "sc_workspace.h"
 #include "sc_fbo.h"
 #include "sc_skia.h"
+#include "sc_sync.h"
 
 struct render_data {
 	struct sc_output *output;
@@ -22,10 +27,17 @@ struct render_data {
 	struct sc_view *view;
 };
 
-void
+extern struct sc_configuration configuration;
+
+bool
 sc_compositor_setup_gles2()
 {
-	sc_renderer_load_shaders();
+	if (!sc_renderer_load_shaders()) {
+		ELOG("error: can't load the shaders\n");
+		return false;
+	}
+	sc_fbo_pool_set_budget((size_t) configuration.fbo_budget * 1024 * 1024);
+	return true;
 }
 
 void
@@ -52,17 +64,18 @@ render_surface(struct wlr_surface *surface, int x, int y, void *data)
 		damaged = pixman_region32_not_empty(&damage);
 	}
 	struct wlr_texture *texture = wlr_surface_get_texture(surface);
+	// only the main surface is clipped, subsurfaces live inside it
+	float corner_radius = surface == view->surface ? view->corner_radius : 0;
 
 	if (damaged && texture != NULL) {
-		struct wlr_gles2_texture_attribs *tex_attribs =
-			malloc(sizeof(struct wlr_gles2_texture_attribs));
-		wlr_gles2_texture_get_attribs(texture, tex_attribs);
-
-		sc_render_texture_with_output(
-			tex_attribs, sx + x, sy + y, surface->current.width,
-			surface->current.height, surface->current.transform, output);
-
-		free(tex_attribs);
+		struct wlr_gles2_texture_attribs tex_attribs;
+		wlr_gles2_texture_get_attribs(texture, &tex_attribs);
+
+		sc_render_texture_region_with_output(
+			&tex_attribs, NULL, sx + x, sy + y, surface->current.width,
+			surface->current.height, surface->current.transform, 1.0f,
+			corner_radius, view->has_color_matrix ? &view->color_matrix : NULL,
+			output);
 	}
 	// damage finish
 	pixman_region32_fini(&damage);
@@ -78,6 +91,51 @@ render_surface(struct wlr_surface *surface, int x, int y, void *data)
 		output->compositor->wlr_presentation, surface, output->wlr_output);
 }
 
+/*
+ * Counts which path the cursor took this frame, reported every 600 frames. A
+ * hardware cursor moves without damage, so it never reaches here on its own;
+ * a software cursor damages its old and new rects, through the output damage.
+ */
+static void
+render_cursors(struct sc_output *output, pixman_region32_t *damage)
+{
+	struct wlr_output *wlr_output = output->wlr_output;
+	struct wlr_output_cursor *cursor;
+	wl_list_for_each (cursor, &wlr_output->cursors, link) {
+		if (!cursor->enabled || !cursor->visible) {
+			continue;
+		}
+		if (cursor == wlr_output->hardware_cursor) {
+			output->cursor_hw_frames++;
+		} else {
+			output->cursor_sw_frames++;
+		}
+		uint64_t frames = output->cursor_hw_frames + output->cursor_sw_frames;
+		if (frames % 600 == 0) {
+			LOG("output %s: cursor on a plane in %llu of %llu frames\n",
+				wlr_output->name,
+				(unsigned long long) output->cursor_hw_frames,
+				(unsigned long long) frames);
+		}
+	}
+	wlr_output_render_software_cursors(wlr_output, damage);
+}
+
+/* a wlr layer list, the oldest surface at the bottom */
+static void
+render_layers_gl(struct wl_list *layers, struct render_data *render_data)
+{
+	struct sc_wlr_layer_view *layer_view;
+	wl_list_for_each_reverse (layer_view, layers, link) {
+		struct sc_view *view = &layer_view->super;
+		if (view->output != render_data->output || !view->mapped) {
+			continue;
+		}
+		render_data->view = view;
+		sc_view_for_each_surface(view, render_surface, render_data);
+	}
+}
+
 void
 sc_render_output_gl(struct sc_output *output, struct timespec *when,
 				 pixman_region32_t *damage)
@@ -86,6 +144,7 @@ sc_render_output_gl(struct sc_output *output, struct timespec *when,
 	struct wlr_renderer *renderer = output->compositor->wlr_renderer;
 
 	wlr_renderer_begin(renderer, wlr_output->width, wlr_output->height);
+	sc_renderer_begin();
 
 	if (!pixman_region32_not_empty(damage)) {
 		// Output isn't damaged but needs buffer swap
@@ -104,16 +163,21 @@ sc_render_output_gl(struct sc_output *output, struct timespec *when,
 
 	struct sc_toplevel_view *toplevel_view;
 	struct sc_workspace *workspace = output->compositor->current_workspace;
+	render_layers_gl(&workspace->layers_background, &render_data);
+	render_layers_gl(&workspace->layers_bottom, &render_data);
 	wl_list_for_each_reverse (toplevel_view, &workspace->views_toplevel, link) {
 
 		render_data.view = &toplevel_view->super;
 		sc_view_for_each_surface(&toplevel_view->super, render_surface,
 								 &render_data);
 	}
+	render_layers_gl(&workspace->layers_top, &render_data);
+	render_layers_gl(&workspace->layers_overlay, &render_data);
+	sc_renderer_flush();
 
 renderer_end:
 	wlr_renderer_scissor(renderer, NULL);
-	wlr_output_render_software_cursors(wlr_output, damage);
+	render_cursors(output, damage);
 	wlr_renderer_end(renderer);
 
 	int width, height;
@@ -134,73 +198,247 @@ renderer_end:
 		return;
 	}
 	output->last_frame = *when;
+	sc_output_frame_committed(output);
 }
 
-bool output_box_is_damged(struct sc_output *output, struct wlr_box *box, pixman_region32_t *output_damage)
+static bool
+render_box_is_damaged(struct wlr_box *box, pixman_region32_t *output_damage)
 {
-	pixman_region32_t damage;
-	pixman_region32_init(&damage);
-	pixman_region32_union_rect(&damage, &damage, box->y, box->y, box->width, box->height);
+	if (output_damage == NULL) {
+		return true;
+	}
+	pixman_box32_t extents = {
+		.x1 = box->x,
+		.y1 = box->y,
+		.x2 = box->x + box->width,
+		.y2 = box->y + box->height,
+	};
+	return pixman_region32_contains_rectangle(output_damage, &extents) !=
+		   PIXMAN_REGION_OUT;
+}
 
-	bool damaged = true;
-	if (output_damage != NULL) {
-		pixman_region32_intersect(&damage, &damage, output_damage);
+/*
+ * Where the surface image, drawn at its buffer size from the top left of
+ * box, hides what's below for sure: every pixel declared opaque and no
+ * rounded corner.
+ */
+static struct wlr_box
+render_item_opaque_box(struct sc_view *view, struct wlr_box *box,
+					   float corner_radius)
+{
+	struct wlr_surface *surface = view->surface;
+	struct wlr_box opaque = {0};
+	if (view->type == SC_VIEW_SCLAYER || corner_radius > 0.0f) {
+		return opaque;
+	}
+	pixman_box32_t extents = {
+		.x1 = 0,
+		.y1 = 0,
+		.x2 = surface->current.width,
+		.y2 = surface->current.height,
+	};
+	if (surface->current.width <= 0 || surface->current.height <= 0 ||
+		pixman_region32_contains_rectangle(&surface->opaque_region,
+										   &extents) != PIXMAN_REGION_IN) {
+		return opaque;
+	}
+	opaque.x = box->x;
+	opaque.y = box->y;
+	opaque.width = surface->current.buffer_width < box->width
+					   ? surface->current.buffer_width
+					   : box->width;
+	opaque.height = surface->current.buffer_height < box->height
+						? surface->current.buffer_height
+						: box->height;
+	return opaque;
+}
 
-		damaged = pixman_region32_not_empty(&damage);
+/*
+ * The snapshot, everything reading the views. The drawing below only gets
+ * the render list.
+ */
+static void
+render_list_add_view(struct sc_render_list *list, struct sc_view *view,
+					 struct sc_view *root, size_t tree, float x, float y,
+					 float scale)
+{
+	if (view->mapped) {
+		struct sc_render_item *item = sc_render_list_add(list);
+		if (item == NULL) {
+			return;
+		}
+		int sx = x * scale;
+		int sy = y * scale;
+		item->surface = view->surface;
+		item->view = root;
+		item->tree = tree;
+		item->box = (struct wlr_box){
+			.x = sx + view->frame.x * scale,
+			.y = sy + view->frame.y * scale,
+			.width = view->frame.width * scale,
+			.height = view->frame.height * scale,
+		};
+		if (view->type == SC_VIEW_SCLAYER) {
+			item->type = SC_RENDER_ITEM_LAYER;
+			item->layer =
+				((struct sc_layer_view *) view)->layer_surface->current;
+		} else {
+			item->type = SC_RENDER_ITEM_SURFACE;
+			item->corner_radius = view->corner_radius * scale;
+			item->has_color_matrix = root->has_color_matrix;
+			item->color_matrix = root->color_matrix;
+		}
+		item->opaque_box =
+			render_item_opaque_box(view, &item->box, item->corner_radius);
+	}
+
+	struct sc_view *subview;
+	wl_list_for_each_reverse (subview, &view->children, link) {
+		render_list_add_view(list, subview, root, tree, x + view->frame.x,
+							 y + view->frame.y, scale);
 	}
-	pixman_region32_fini(&damage);
-	return damaged;
 }
 
-void
-sc_render_view(struct sc_view *view, float x, float y, pixman_region32_t *output_damage)
+static void
+render_list_add_tree(struct sc_render_list *list, struct sc_view *view,
+					 float scale)
 {
-	int sx = x*view->output->wlr_output->scale;
-	int sy = y*view->output->wlr_output->scale;
-
-	struct wlr_box box = {
-		.x = sx + view->frame.x * view->output->wlr_output->scale,
-		.y = sy + view->frame.y * view->output->wlr_output->scale,
-		.width = view->frame.width * view->output->wlr_output->scale,
-		.height = view->frame.height * view->output->wlr_output->scale,
-	};
+	size_t first = list->len;
+	render_list_add_view(list, view, view, first, 0, 0, scale);
+}
 
-	LOG("draw\n");
-	if (output_box_is_damged(view->output, &box, output_damage) || true) {
-
-		if(view->mapped) {
-			LOG("view mapped\n");
-			if(view->type == SC_VIEW_SCLAYER) {
-				LOG("view layer\n");
-				skia_draw_layer(view->output->skia, view->surface, &((struct sc_layer_view*)view)->layer_surface->current);
-			} else {
-				LOG("view surface\n");
-				skia_draw_surface(view->output->skia, view->surface, box.x, box.y, box.width, box.height);
-			}
+static void
+render_list_add_layers(struct sc_render_list *list, struct sc_output *output,
+					   struct wl_list *layers, float scale)
+{
+	struct sc_wlr_layer_view *layer_view;
+	wl_list_for_each_reverse (layer_view, layers, link) {
+		if (layer_view->super.output != output || !layer_view->super.mapped) {
+			continue;
 		}
+		render_list_add_tree(list, &layer_view->super, scale);
 	}
-	// damage finish
+}
 
-	struct timespec repaint_time;
+/* only when the scene changed since the last one, the list is kept */
+static void
+render_list_update(struct sc_output *output, struct sc_render_list *list)
+{
+	struct sc_compositor *compositor = output->compositor;
+	if (list->valid && list->scene_serial == compositor->scene_serial) {
+		return;
+	}
+	struct sc_workspace *workspace = compositor->current_workspace;
+	float scale = output->wlr_output->scale;
 
-	clockid_t presentation_clock =
-		wlr_backend_get_presentation_clock(view->output->compositor->wlr_backend);
+	sc_render_list_reset(list);
+	render_list_add_layers(list, output, &workspace->layers_background,
+						   scale);
+	list->background_len = list->len;
+	render_list_add_layers(list, output, &workspace->layers_bottom, scale);
 
-	clock_gettime(presentation_clock, &repaint_time);
+	struct sc_toplevel_view *toplevel_view;
+	wl_list_for_each_reverse (toplevel_view, &workspace->views_toplevel, link) {
+		render_list_add_tree(list, &toplevel_view->super, scale);
+	}
+	struct sc_layer_view *layer_view;
+	wl_list_for_each_reverse (layer_view, &workspace->sc_layers, link) {
+		render_list_add_tree(list, &layer_view->super, scale);
+	}
+	render_list_add_layers(list, output, &workspace->layers_top, scale);
+	render_list_add_layers(list, output, &workspace->layers_overlay, scale);
 
-	wlr_presentation_surface_sampled_on_output(
-		view->output->compositor->wlr_presentation, view->surface, view->output->wlr_output);
+	struct wlr_box bounds = {
+		.width = output->fbo->width,
+		.height = output->fbo->height,
+	};
+	sc_render_list_cull(list, &bounds);
+	sc_output_set_content_view(output,
+							   sc_render_list_fullscreen_view(list, &bounds));
+	list->scene_serial = compositor->scene_serial;
+	list->valid = true;
+}
 
-	struct sc_view *subview;
-	wl_list_for_each_reverse(subview, &view->children, link) {
-		sc_render_view(subview, x+view->frame.x, y+view->frame.y, output_damage);
+/* the surfaces that made it to the frame */
+static void
+render_list_sampled(struct sc_output *output, struct sc_render_list *list)
+{
+	for (size_t i = 0; i < list->len; i++) {
+		struct sc_render_item *item = &list->items[i];
+		if (item->occluded) {
+			continue;
+		}
+		sc_sync_surface_acquire(item->surface);
+		wlr_presentation_surface_sampled_on_output(
+			output->compositor->wlr_presentation, item->surface,
+			output->wlr_output);
+	}
+}
+
+static void
+render_list_release(struct sc_render_list *list)
+{
+	int fence_fd = sc_sync_frame_fence();
+	if (fence_fd < 0) {
+		return;
+	}
+	for (size_t i = 0; i < list->len; i++) {
+		if (!list->items[i].occluded) {
+			sc_sync_surface_release(list->items[i].surface, fence_fd);
+		}
 	}
+	close(fence_fd);
+}
+
+static void
+render_list_draw_items(struct skia_context *skia, struct sc_render_item *items,
+					   size_t count, pixman_region32_t *damage)
+{
+	for (size_t i = 0; i < count; i++) {
+		struct sc_render_item *item = &items[i];
+		if (item->occluded || !render_box_is_damaged(&item->box, damage)) {
+			continue;
+		}
+		switch (item->type) {
+		case SC_RENDER_ITEM_LAYER:
+			skia_draw_layer(skia, item->surface, &item->layer);
+			break;
+		case SC_RENDER_ITEM_SURFACE:
+			skia_draw_surface(skia, item->surface, item->box.x, item->box.y,
+							  item->box.width, item->box.height,
+							  item->corner_radius,
+							  item->has_color_matrix ? &item->color_matrix
+													 : NULL);
+			break;
+		}
+	}
+}
+
+static void
+render_list_draw(struct skia_context *skia, struct sc_render_list *list,
+				 pixman_region32_t *damage)
+{
+	skia_draw(skia, damage);
+	// the background layer changes rarely, windows move over it all the time
+	if (skia_background_begin(skia)) {
+		render_list_draw_items(skia, list->items, list->background_len, NULL);
+		skia_background_end(skia);
+	}
+	render_list_draw_items(skia, list->items + list->background_len,
+						   list->len - list->background_len, damage);
+	skia_submit(skia);
 }
 
 void
 sc_render_output(struct sc_output *output, struct timespec *when,
 				 pixman_region32_t *output_damage)
 {
+	if (output->fbo == NULL || output->skia == NULL) {
+		// the fbo didn't fit in the pool, skip the skia composition
+		sc_render_output_gl(output, when, output_damage);
+		return;
+	}
+
 	struct wlr_output *wlr_output = output->wlr_output;
 	struct wlr_renderer *renderer = output->compositor->wlr_renderer;
 
@@ -211,28 +449,16 @@ sc_render_output(struct sc_output *output, struct timespec *when,
 		goto renderer_end;
 	}
 
+	render_list_update(output, &output->render_list);
+	render_list_sampled(output, &output->render_list);
+
 	GLint currentFb = 0;
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &currentFb);
 	glBindFramebuffer(GL_FRAMEBUFFER, output->fbo->framebuffer);
-	skia_draw(output->skia);
-
-	struct sc_workspace *workspace = output->compositor->current_workspace;
-
-	LOG("render output\n");
-	struct sc_toplevel_view *toplevel_view;
-	wl_list_for_each_reverse (toplevel_view, &workspace->views_toplevel, link) {
-		sc_render_view(&toplevel_view->super, 0, 0, output_damage);
-	}
-	struct sc_layer_view *layer_view;
-	wl_list_for_each_reverse (layer_view, &workspace->sc_layers, link) {
-		LOG("render sc layer\n");
-		sc_render_view(&layer_view->super, 0, 0, output_damage);
-	}
-
-	skia_submit(output->skia);
-
- 	glBindFramebuffer(GL_FRAMEBUFFER, currentFb);
-
+	render_list_draw(output->skia, &output->render_list, output_damage);
+	glBindFramebuffer(GL_FRAMEBUFFER, currentFb);
+	// skia leaves the GL state in an unknown state
+	sc_renderer_begin();
 
 	struct wlr_gles2_texture_attribs *tex_attribs =
 			malloc(sizeof(struct wlr_gles2_texture_attribs));
@@ -243,13 +469,15 @@ sc_render_output(struct sc_output *output, struct timespec *when,
 	sc_render_texture_with_output(
 		tex_attribs, 0, 0, output->fbo->width,
 		output->fbo->height, WL_OUTPUT_TRANSFORM_FLIPPED_180, output);
+	sc_renderer_flush();
+	render_list_release(&output->render_list);
 
 	free(tex_attribs);
 renderer_end:
 	
 	
 	wlr_renderer_scissor(renderer, NULL);
-	wlr_output_render_software_cursors(wlr_output, output_damage);
+	render_cursors(output, output_damage);
 	wlr_renderer_end(renderer);
 
 
@@ -271,4 +499,5 @@ renderer_end:
 		return;
 	}
 	output->last_frame = *when;
+	sc_output_frame_committed(output);
 }
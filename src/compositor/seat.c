@@ -24,6 +24,7 @@ request_set_cursor(struct wl_listener *listener, void *data)
 
 		wlr_cursor_set_surface(compositor->cursor, event->surface,
 							   event->hotspot_x, event->hotspot_y);
+		compositor->cursor_image = NULL;
 	}
 }
 
@@ -8,10 +8,13 @@
 #include "skia.hpp"
 #include <map>
 #include <include/core/SkCanvas.h>
+#include <include/core/SkColorFilter.h>
 #include <include/core/SkFont.h>
 #include <include/core/SkFontMgr.h>
 #include <include/core/SkRRect.h>
 #include <include/core/SkRegion.h>
+#include <include/core/SkSamplingOptions.h>
+#include <include/core/SkShader.h>
 #include <include/core/SkBlurTypes.h>
 #include <include/effects/SkImageFilters.h>
 #include <include/core/SkTextBlob.h>
@@ -22,6 +25,7 @@
 
 extern "C" {
 #include "log.h"
+#include "sc_color_matrix.h"
 #include "sc_fbo.h"
 #include <wlr/util/log.h>
 #include "sc_skia.h"
@@ -36,21 +40,8 @@ void load_bg() {
     bg_img = SkImage::MakeFromEncoded(img_data);
 }
 
-extern "C" struct skia_context *skia_context_create_for_view(struct sc_fbo *fbo)
+extern "C" bool skia_context_set_fbo(struct skia_context *skia, struct sc_fbo *fbo)
 {
-    struct skia_context *skia = (struct skia_context *)calloc(1, sizeof(struct skia_context));
-
-    auto gl = GrGLMakeNativeInterface();
-    gl->ref();
-    skia->context = GrDirectContext::MakeGL(gl);
-    skia->context->ref();
-
-    SkImageInfo info = SkImageInfo:: MakeN32Premul(fbo->width * 1,
-                                    fbo->height * 1);
-
-    GrGLint buffer;
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &buffer);
-
     GrGLFramebufferInfo fbInfo;
     fbInfo.fFBOID = fbo->framebuffer;
     fbInfo.fFormat = GL_RGBA8_OES;
@@ -61,44 +52,59 @@ extern "C" struct skia_context *skia_context_create_for_view(struct sc_fbo *fbo)
                                     8,
                                     fbInfo);
 
+    // the previous surface, if any, is released by the assignment
     skia->surface = SkSurface::MakeFromBackendRenderTarget(skia->context.get(), backendRT,
                                                        kBottomLeft_GrSurfaceOrigin,
                                                        kRGBA_8888_SkColorType,
                                                        nullptr,
                                                        nullptr);
-    skia->surface->ref();
     if (!skia->surface) {
         SkDebugf("SkSurface::MakeRenderTarget returned null\n");
-        exit(1);
-    }    
-    
+        return false;
+    }
+    return true;
+}
+
+extern "C" struct skia_context *skia_context_create_for_view(struct sc_fbo *fbo)
+{
+    struct skia_context *skia = (struct skia_context *)calloc(1, sizeof(struct skia_context));
+
+    auto gl = GrGLMakeNativeInterface();
+    gl->ref();
+    skia->context = GrDirectContext::MakeGL(gl);
+    skia->context->ref();
+
+    if (!skia_context_set_fbo(skia, fbo)) {
+        ELOG("skia: unable to wrap the output framebuffer\n");
+        // drops the extra reference taken above, then the last one
+        skia->context->unref();
+        skia->context.reset();
+        free(skia);
+        return NULL;
+    }
+
     return skia;
 }
 
-extern "C" void skia_draw(struct skia_context *skia) {
+static SkCanvas *skia_canvas(struct skia_context *skia) {
+    if (skia->drawing_background) {
+        return skia->background->getCanvas();
+    }
+    return skia->surface->getCanvas();
+}
 
-    skia->context->resetContext();
+static void draw_background(SkCanvas *canvas) {
     if(bg_img == NULL) {
         load_bg();
     }
-    SkCanvas *canvas = skia->surface->getCanvas();
-    canvas->resetMatrix();
-    
     canvas->clear(0xFF000000);
     canvas->drawImage(bg_img, 0, 0);
 
-    SkPaint p;
-	p.setStrokeWidth(1);
-	p.setColor(0xFFfff6f6);
-	p.setAntiAlias(true);
-	p.setStyle(SkPaint::kFill_Style);
-
 	SkPaint paint;
 	SkFont font = SkFont();
     
 	sk_sp<SkTypeface> tf = SkTypeface::MakeFromName("TeX Gyre Heros", SkFontStyle::Bold());
     //sk_sp<SkTypeface> emojitf = SkTypeface::MakeFromName("Emoji", SkFontStyle());
-	;
 	paint.setStyle(SkPaint::kFill_Style);
 	paint.setColor(0xFF000000);
 
@@ -107,12 +113,68 @@ extern "C" void skia_draw(struct skia_context *skia) {
     std::string text = "Screen Composer";
     sk_sp<SkTextBlob> blob = SkTextBlob::MakeFromString(text.c_str(), font, SkTextEncoding::kUTF8);
 
-    
     canvas->drawTextBlob(blob.get(), 10, 22, paint);
-  
+}
+
+extern "C" void skia_draw(struct skia_context *skia, pixman_region32_t *damage) {
+
+    skia->context->resetContext();
+    SkCanvas *canvas = skia->surface->getCanvas();
+    canvas->resetMatrix();
+
+    // the fbo keeps the previous frame, only the damaged rects are redrawn
+    SkRegion clip;
+    int nrects;
+    pixman_box32_t *rects = pixman_region32_rectangles(damage, &nrects);
+    for (int i = 0; i < nrects; i++) {
+        clip.op(SkIRect::MakeLTRB(rects[i].x1, rects[i].y1, rects[i].x2, rects[i].y2),
+                SkRegion::kUnion_Op);
+    }
+    canvas->save();
+    canvas->clipRegion(clip);
+    canvas->clear(0xFF000000);
+}
+
+extern "C" bool skia_background_begin(struct skia_context *skia) {
+    SkCanvas *canvas = skia->surface->getCanvas();
+    if (skia->background_image) {
+        canvas->drawImage(skia->background_image, 0, 0);
+        return false;
+    }
+
+    int width = skia->surface->width();
+    int height = skia->surface->height();
+    if (!skia->background || skia->background->width() != width ||
+            skia->background->height() != height) {
+        skia->background = SkSurface::MakeRenderTarget(skia->context.get(),
+                SkBudgeted::kYes, SkImageInfo::MakeN32Premul(width, height));
+    }
+    if (!skia->background) {
+        // no room for the cache, draw straight into the frame
+        draw_background(canvas);
+        return true;
+    }
+    skia->drawing_background = true;
+    draw_background(skia->background->getCanvas());
+    return true;
+}
+
+extern "C" void skia_background_end(struct skia_context *skia) {
+    if (!skia->drawing_background) {
+        return;
+    }
+    skia->drawing_background = false;
+    skia->background_image = skia->background->makeImageSnapshot();
+    skia->surface->getCanvas()->drawImage(skia->background_image, 0, 0);
+}
+
+extern "C" void skia_invalidate_background(struct skia_context *skia) {
+    // dropping the snapshot first spares a copy when the surface is redrawn
+    skia->background_image.reset();
 }
 
 extern "C" void skia_submit(struct skia_context *skia) {
+    skia->surface->getCanvas()->restore();
     skia->context->flushAndSubmit();
      glUseProgram(0);
      
@@ -161,12 +223,40 @@ extern "C" struct skia_image *skia_image_from_texture(struct skia_context *skia,
     return skia_image;
 }
 
-extern "C" void skia_draw_surface(struct skia_context *skia, struct wlr_surface *surface, int x, int y, int w, int h) {
+/*
+ * Fills rrect with the image placed at x, y. Skia draws filled rrects
+ * analytically, coverage comes from the rrect distance in the fragment shader,
+ * while a clipRRect would go through the stencil or a coverage mask.
+ */
+static void draw_image_rrect(SkCanvas *canvas, sk_sp<SkImage> image, float x, float y, const SkRRect &rrect,
+        const SkPaint &paint) {
+    SkMatrix matrix = SkMatrix::Translate(x, y);
+    SkPaint p(paint);
+    p.setAntiAlias(true);
+    p.setShader(image->makeShader(SkTileMode::kClamp, SkTileMode::kClamp,
+                SkSamplingOptions(SkFilterMode::kLinear), &matrix));
+    canvas->drawRRect(rrect, p);
+}
+
+/* Skia takes it row major, with the offset as a fifth column */
+static sk_sp<SkColorFilter> color_matrix_filter(const struct sc_color_matrix *color_matrix) {
+    float row_major[20];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            row_major[row * 5 + col] = color_matrix->matrix[col * 4 + row];
+        }
+        row_major[row * 5 + 4] = color_matrix->offset[row];
+    }
+    return SkColorFilters::Matrix(row_major);
+}
+
+extern "C" void skia_draw_surface(struct skia_context *skia, struct wlr_surface *surface, int x, int y, int w, int h, float corner_radius,
+        const struct sc_color_matrix *color_matrix) {
 
     struct skia_image * skia_image = skia_images_cache[surface];
 
     if(skia_image != NULL) {
-         SkCanvas *canvas = skia->surface->getCanvas();
+         SkCanvas *canvas = skia_canvas(skia);
 
        // SkMatrix matrix;
        // matrix.setScale(0.5f, 0.5f);
@@ -186,28 +276,37 @@ extern "C" void skia_draw_surface(struct skia_context *skia, struct wlr_surface
         // SkIPoint offset;
         // sk_sp<SkImage> filtered(image->makeWithFilter(canvas->recordingContext(), offsetFilter.get(),
                                                     // subset, clipBounds, &outSubset, &offset));
-        canvas->drawImage(image, x, y);
-
+        SkPaint paint;
+        if (color_matrix != NULL) {
+            paint.setColorFilter(color_matrix_filter(color_matrix));
+        }
+        if (corner_radius > 0) {
+            SkRRect rrect = SkRRect::MakeRectXY(
+                SkRect::MakeXYWH(x, y, image->width(), image->height()),
+                corner_radius, corner_radius);
+            draw_image_rrect(canvas, image, x, y, rrect, paint);
+        } else {
+            canvas->drawImage(image, x, y, SkSamplingOptions(), &paint);
+        }
     }
 }
 
 extern "C" void skia_draw_layer(struct skia_context *skia, struct wlr_surface *surface, struct sc_layer_v1_state *layer){
-    LOG("draw layer\n");
 //    struct sc_view *view = layer->base;
     struct skia_image * skia_image = skia_images_cache[surface];
 
     if(skia_image != NULL) {
-        SkCanvas *canvas = skia->surface->getCanvas();
+        SkCanvas *canvas = skia_canvas(skia);
 
         sk_sp<SkImage> image = skia_image->img;
         
                                                     // subset, clipBounds, &outSubset, &offset));
-        SkRRect rrect = SkRRect::MakeRectXY({
+        SkRRect rrect = SkRRect::MakeRectXY(SkRect::MakeXYWH(
             (float)layer->position.x,
             (float)layer->position.y,
             (float)layer->bounds.width,
             (float)layer->bounds.height
-        },
+        ),
             (float)layer->border_corner_radius,
             (float)layer->border_corner_radius);
         SkPaint p;
@@ -220,6 +319,10 @@ extern "C" void skia_draw_layer(struct skia_context *skia, struct wlr_surface *s
             layer->background_color.b)
         );
         canvas->drawRRect(rrect, p);
+
+        // the surface, clipped to the layer corners, below the border
+        draw_image_rrect(canvas, image, layer->position.x, layer->position.y, rrect, SkPaint());
+
         p.setStyle(SkPaint::kStroke_Style);
         p.setStrokeWidth((float)layer->border_width);
         p.setColor(SkColorSetARGB(
@@ -230,9 +333,6 @@ extern "C" void skia_draw_layer(struct skia_context *skia, struct wlr_surface *s
         );
         canvas->drawRRect(rrect, p);
 
-        // draw the surface on top of the layer
-        //canvas->drawImage(image, layer->position.x, layer->position.y);
-
     }
 }
 
@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <wlr/render/gles2.h>
+#include <wlr/types/wlr_matrix.h>
+
+#include "gles2_renderer.h"
+#include "log.h"
+#include "sc_compositor.h"
+#include "sc_config.h"
+#include "sc_downscale.h"
+#include "sc_fbo.h"
+#include "sc_thumbnail.h"
+#include "sc_toplevel_view.h"
+#include "sc_view.h"
+#include "sc_workspace.h"
+
+#define SC_THUMBNAIL_DEFAULT_RATE 10
+#define SC_THUMBNAIL_MAX_LEVELS 8
+
+extern struct sc_configuration configuration;
+
+struct thumbnail_draw_data {
+	const float *projection;
+	double scale;
+	int x, y; // of the view, relative to the thumbnail source
+};
+
+static int
+thumbnail_interval_ms()
+{
+	int rate = configuration.thumbnail_rate > 0 ? configuration.thumbnail_rate
+												: SC_THUMBNAIL_DEFAULT_RATE;
+	int interval = 1000 / rate;
+	return interval > 0 ? interval : 1;
+}
+
+static uint32_t
+thumbnail_source_serial(struct sc_thumbnail *thumbnail)
+{
+	if (thumbnail->view != NULL) {
+		return thumbnail->view->content_serial;
+	}
+	return thumbnail->workspace->content_serial;
+}
+
+static void
+thumbnail_draw_surface(struct wlr_surface *surface, int x, int y, void *data)
+{
+	struct thumbnail_draw_data *draw = data;
+
+	struct wlr_texture *texture = wlr_surface_get_texture(surface);
+	if (texture == NULL) {
+		return;
+	}
+	struct wlr_gles2_texture_attribs tex_attribs;
+	wlr_gles2_texture_get_attribs(texture, &tex_attribs);
+
+	int sx = (int) ((draw->x + x) * draw->scale);
+	int sy = (int) ((draw->y + y) * draw->scale);
+	int w = (int) ((draw->x + x + surface->current.width) * draw->scale) - sx;
+	int h = (int) ((draw->y + y + surface->current.height) * draw->scale) - sy;
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+	sc_render_texture_region_with_projection(&tex_attribs, NULL, sx, sy, w, h,
+											 surface->current.transform, 1.0f,
+											 0.0f, NULL, draw->projection);
+}
+
+static void
+thumbnail_draw_view(struct sc_view *view, int x, int y,
+					struct thumbnail_draw_data *draw)
+{
+	if (!view->mapped) {
+		return;
+	}
+	draw->x = x;
+	draw->y = y;
+	sc_view_for_each_surface(view, thumbnail_draw_surface, draw);
+}
+
+/* the source at the size of the first level */
+static void
+thumbnail_draw_source(struct sc_thumbnail *thumbnail, struct wlr_box *source,
+					  struct thumbnail_draw_data *draw)
+{
+	if (thumbnail->view != NULL) {
+		thumbnail_draw_view(thumbnail->view, 0, 0, draw);
+		return;
+	}
+	struct sc_toplevel_view *toplevel;
+	wl_list_for_each_reverse (toplevel, &thumbnail->workspace->views_toplevel,
+							  link) {
+		struct sc_view *view = &toplevel->super;
+		thumbnail_draw_view(view, view->frame.x - source->x,
+							view->frame.y - source->y, draw);
+	}
+}
+
+static bool
+thumbnail_source_box(struct sc_thumbnail *thumbnail, struct wlr_box *box)
+{
+	if (thumbnail->view != NULL) {
+		*box = thumbnail->view->frame;
+		box->x = 0;
+		box->y = 0;
+		return thumbnail->view->mapped;
+	}
+	struct wlr_box *layout =
+		wlr_output_layout_get_box(thumbnail->compositor->output_layout, NULL);
+	if (layout == NULL) {
+		return false;
+	}
+	*box = *layout;
+	return true;
+}
+
+static bool
+thumbnail_render(struct sc_thumbnail *thumbnail)
+{
+	struct wlr_box source;
+	if (!thumbnail_source_box(thumbnail, &source)) {
+		return false;
+	}
+	struct sc_downscale_level levels[SC_THUMBNAIL_MAX_LEVELS];
+	size_t count = sc_downscale_levels(
+		source.width, source.height, thumbnail->max_width,
+		thumbnail->max_height, levels, SC_THUMBNAIL_MAX_LEVELS);
+	if (count == 0) {
+		return false;
+	}
+
+	struct sc_fbo *fbo = NULL;
+	for (size_t i = 0; i < count; i++) {
+		struct sc_fbo *next =
+			sc_fbo_pool_acquire(levels[i].width, levels[i].height, GL_RGBA);
+		if (next == NULL) {
+			sc_fbo_pool_release(fbo);
+			return false;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, next->framebuffer);
+		glViewport(0, 0, next->width, next->height);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		float projection[9];
+		wlr_matrix_projection(projection, next->width, next->height,
+							  WL_OUTPUT_TRANSFORM_NORMAL);
+		sc_renderer_begin();
+		if (fbo == NULL) {
+			struct thumbnail_draw_data draw = {
+				.projection = projection,
+				.scale = (double) next->width / source.width,
+			};
+			thumbnail_draw_source(thumbnail, &source, &draw);
+		} else {
+			struct wlr_gles2_texture_attribs tex_attribs = {
+				.target = GL_TEXTURE_2D,
+				.tex = fbo->tex,
+				.has_alpha = true,
+			};
+			sc_render_texture_region_with_projection(
+				&tex_attribs, NULL, 0, 0, next->width, next->height,
+				WL_OUTPUT_TRANSFORM_NORMAL, 1.0f, 0.0f, NULL, projection);
+		}
+		sc_renderer_flush();
+
+		sc_fbo_pool_release(fbo);
+		fbo = next;
+	}
+
+	sc_fbo_pool_release(thumbnail->fbo);
+	thumbnail->fbo = fbo;
+	thumbnail->width = levels[count - 1].width;
+	thumbnail->height = levels[count - 1].height;
+	return true;
+}
+
+static int
+thumbnails_update(void *data)
+{
+	struct sc_compositor *compositor = data;
+	if (wl_list_empty(&compositor->thumbnails)) {
+		// started again by the next thumbnail
+		return 0;
+	}
+
+	gl_begin();
+	GLint framebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+	struct sc_thumbnail *thumbnail, *tmp;
+	wl_list_for_each_safe (thumbnail, tmp, &compositor->thumbnails, link) {
+		if (thumbnail->view == NULL && thumbnail->workspace == NULL) {
+			continue;
+		}
+		uint32_t serial = thumbnail_source_serial(thumbnail);
+		if (thumbnail->fbo != NULL && serial == thumbnail->content_serial) {
+			continue;
+		}
+		if (!thumbnail_render(thumbnail)) {
+			continue;
+		}
+		thumbnail->content_serial = serial;
+		wl_signal_emit(&thumbnail->events.update, thumbnail);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	wl_event_source_timer_update(compositor->thumbnail_timer,
+								 thumbnail_interval_ms());
+	return 0;
+}
+
+static struct sc_thumbnail *
+thumbnail_create(struct sc_compositor *compositor, int max_width,
+				 int max_height)
+{
+	struct sc_thumbnail *thumbnail = calloc(1, sizeof(struct sc_thumbnail));
+	if (thumbnail == NULL) {
+		return NULL;
+	}
+	thumbnail->compositor = compositor;
+	thumbnail->max_width = max_width;
+	thumbnail->max_height = max_height;
+	wl_signal_init(&thumbnail->events.update);
+
+	if (wl_list_empty(&compositor->thumbnails)) {
+		// the first image doesn't wait for a whole interval
+		wl_event_source_timer_update(compositor->thumbnail_timer, 1);
+	}
+	wl_list_insert(compositor->thumbnails.prev, &thumbnail->link);
+	return thumbnail;
+}
+
+struct sc_thumbnail *
+sc_thumbnail_create_for_view(struct sc_compositor *compositor,
+							 struct sc_view *view, int max_width,
+							 int max_height)
+{
+	struct sc_thumbnail *thumbnail =
+		thumbnail_create(compositor, max_width, max_height);
+	if (thumbnail != NULL) {
+		thumbnail->view = view;
+	}
+	return thumbnail;
+}
+
+struct sc_thumbnail *
+sc_thumbnail_create_for_workspace(struct sc_compositor *compositor,
+								  struct sc_workspace *workspace,
+								  int max_width, int max_height)
+{
+	struct sc_thumbnail *thumbnail =
+		thumbnail_create(compositor, max_width, max_height);
+	if (thumbnail != NULL) {
+		thumbnail->workspace = workspace;
+	}
+	return thumbnail;
+}
+
+void
+sc_compositor_setup_thumbnails(struct sc_compositor *compositor)
+{
+	wl_list_init(&compositor->thumbnails);
+	compositor->thumbnail_timer = wl_event_loop_add_timer(
+		compositor->wl_event_loop, thumbnails_update, compositor);
+
+	struct sc_workspace *workspace;
+	wl_list_for_each (workspace, &compositor->workspaces, link) {
+		workspace->thumbnail = sc_thumbnail_create_for_workspace(
+			compositor, workspace, SC_THUMBNAIL_SIZE, SC_THUMBNAIL_SIZE);
+	}
+}
+
+void
+sc_thumbnail_destroy(struct sc_thumbnail *thumbnail)
+{
+	if (thumbnail == NULL) {
+		return;
+	}
+	wl_list_remove(&thumbnail->link);
+	sc_fbo_pool_release(thumbnail->fbo);
+	free(thumbnail);
+}
+
+void
+sc_thumbnails_forget_view(struct sc_compositor *compositor,
+						  struct sc_view *view)
+{
+	struct sc_thumbnail *thumbnail;
+	wl_list_for_each (thumbnail, &compositor->thumbnails, link) {
+		if (thumbnail->view == view) {
+			thumbnail->view = NULL;
+		}
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "log.h"
 #include "sc_compositor.h"
+#include "sc_output.h"
 #include "sc_wlr_layer_view.h"
 #include "sc_view.h"
 
@@ -17,7 +18,24 @@ compositor_layer_surface_new(struct wl_listener *listener, void *data)
 
 	struct wlr_layer_surface_v1 *layer_surface = data;
 
-	sc_wlr_layer_view_create(layer_surface, compositor);
+	// the client can leave the choice of the output to us
+	struct sc_output *output = NULL;
+	struct sc_output *candidate;
+	wl_list_for_each (candidate, &compositor->outputs, link) {
+		if (layer_surface->output == NULL ||
+			layer_surface->output == candidate->wlr_output) {
+			output = candidate;
+			break;
+		}
+	}
+	if (output == NULL) {
+		ELOG("no output for the layer surface\n");
+		wlr_layer_surface_v1_destroy(layer_surface);
+		return;
+	}
+	layer_surface->output = output->wlr_output;
+
+	sc_wlr_layer_view_create(layer_surface, compositor, output);
 }
 
 void
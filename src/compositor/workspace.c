@@ -4,21 +4,123 @@
 #include "log.h"
 #include "sc_compositor.h"
 #include "sc_compositor_workspace.h"
+#include "sc_config.h"
+#include "sc_output.h"
 #include "sc_wlr_layer_view.h"
 #include "sc_toplevel_view.h"
 #include "sc_layer_view.h"
 #include "sc_view.h"
 #include "sc_workspace.h"
 
+extern struct sc_configuration configuration;
+
 void
 sc_compositor_setup_workspaces(struct sc_compositor *compositor)
 {
 	wl_list_init(&compositor->workspaces);
 
-	struct sc_workspace *workspace = sc_workspace_create();
+	int count = configuration.workspaces > 0 ? configuration.workspaces : 1;
+	for (int i = 0; i < count; i++) {
+		struct sc_workspace *workspace = sc_workspace_create();
+		workspace->index = i;
+		wl_list_insert(compositor->workspaces.prev, &workspace->link);
+	}
+	compositor->current_workspace =
+		wl_container_of(compositor->workspaces.next,
+						compositor->current_workspace, link);
+}
+
+/*
+ * The layer shell surfaces (panels, backgrounds, ...) are on every workspace:
+ * they follow the one shown, with their index entries.
+ */
+static void
+workspace_move_wlr_layers(struct sc_workspace *from, struct sc_workspace *to)
+{
+	struct wl_list *from_layers[] = {
+		&from->layers_background,
+		&from->layers_bottom,
+		&from->layers_top,
+		&from->layers_overlay,
+	};
+	struct wl_list *to_layers[] = {
+		&to->layers_background,
+		&to->layers_bottom,
+		&to->layers_top,
+		&to->layers_overlay,
+	};
+	for (size_t i = 0; i < sizeof(to_layers) / sizeof(to_layers[0]); i++) {
+		wl_list_insert_list(to_layers[i], from_layers[i]);
+		wl_list_init(from_layers[i]);
+
+		struct sc_wlr_layer_view *layer;
+		wl_list_for_each (layer, to_layers[i], link) {
+			sc_view_remove_index(&layer->super);
+			layer->super.workspace = to;
+			sc_view_update_index(&layer->super);
+		}
+	}
+}
+
+void
+sc_compositor_switch_workspace(struct sc_compositor *compositor,
+							   struct sc_workspace *workspace)
+{
+	struct sc_workspace *previous = compositor->current_workspace;
+	if (workspace == previous) {
+		return;
+	}
+	DLOG("switching to workspace %d\n", workspace->index);
+
+	// the grab and the focus stay behind with the hidden views
+	compositor->grabbed_view = NULL;
+	compositor->cursor_mode = SC_CURSOR_PASSTHROUGH;
+	if (compositor->current_view != NULL) {
+		sc_view_deactivate(compositor->current_view);
+		compositor->current_view = NULL;
+	}
+	wlr_seat_keyboard_clear_focus(compositor->seat);
+
+	// what gets rendered, hit tested and sent frame callbacks is all read
+	// from the current workspace, the hidden ones cost nothing
+	workspace_move_wlr_layers(previous, workspace);
 	compositor->current_workspace = workspace;
+	compositor->scene_serial++;
 
-	wl_list_insert(&compositor->workspaces, &workspace->link);
+	struct sc_output *output;
+	wl_list_for_each (output, &compositor->outputs, link) {
+		wlr_output_damage_add_whole(output->damage);
+	}
+
+	if (!wl_list_empty(&workspace->views_toplevel)) {
+		struct sc_toplevel_view *toplevel =
+			wl_container_of(workspace->views_toplevel.next, toplevel, link);
+		sc_composer_focus_view(compositor, &toplevel->super);
+	}
+	// the pointer focus follows with the next frame
+	compositor->cursor_motion_pending = true;
+}
+
+void
+sc_compositor_switch_workspace_next(struct sc_compositor *compositor)
+{
+	struct wl_list *next = compositor->current_workspace->link.next;
+	if (next == &compositor->workspaces) {
+		next = next->next;
+	}
+	struct sc_workspace *workspace = wl_container_of(next, workspace, link);
+	sc_compositor_switch_workspace(compositor, workspace);
+}
+
+void
+sc_compositor_switch_workspace_previous(struct sc_compositor *compositor)
+{
+	struct wl_list *prev = compositor->current_workspace->link.prev;
+	if (prev == &compositor->workspaces) {
+		prev = prev->prev;
+	}
+	struct sc_workspace *workspace = wl_container_of(prev, workspace, link);
+	sc_compositor_switch_workspace(compositor, workspace);
 }
 
 void
@@ -33,6 +135,9 @@ sc_compositor_add_toplevel(struct sc_compositor *compositor,
 	struct sc_view *view = (struct sc_view *) toplevelview;
 	view->frame.x = numtoplevels * 50;
 	view->frame.y = numtoplevels * 50;
+
+	view->workspace = compositor->current_workspace;
+	sc_view_raise(view);
 }
 
 void
@@ -41,6 +146,8 @@ sc_compositor_add_layer(struct sc_compositor *compositor,
 {
 	wl_list_insert(&compositor->current_workspace->sc_layers,
 				   &layerview->link);
+	layerview->super.workspace = compositor->current_workspace;
+	sc_view_raise(&layerview->super);
 	sc_composer_focus_view(compositor, (struct sc_view*)&layerview->super);
 }
 
@@ -72,22 +179,37 @@ sc_compositor_add_wlr_layer(struct sc_compositor *compositor,
 					   &layer->link);
 		break;
 	}
+	layer->layer = layer->layer_surface->pending.layer;
+	layer->super.workspace = compositor->current_workspace;
+	sc_view_raise(&layer->super);
 }
 
+// views stacked over a single point, beyond that the lowest are ignored
+#define SC_VIEW_AT_MAX_CANDIDATES 32
+
 struct sc_view *
 sc_composer_view_at(struct sc_compositor *compositor, double x, double y,
 					struct wlr_surface **surface, double *sx, double *sy)
 {
-	struct sc_toplevel_view *toplevel_view;
 	struct sc_workspace *workspace = compositor->current_workspace;
-	wl_list_for_each (toplevel_view, &workspace->views_toplevel, link) {
-		struct sc_view *view = &toplevel_view->super;
-		*surface = sc_view_surface_at(view, x, y, sx, sy);
+	struct sc_spatial_grid_entry *hits[SC_VIEW_AT_MAX_CANDIDATES];
+	size_t count = sc_spatial_grid_query(&workspace->view_index, x, y, hits,
+										 SC_VIEW_AT_MAX_CANDIDATES);
 
-		if (*surface != NULL) {
-			return view;
+	// the boxes are conservative, the surfaces decide (input region, holes)
+	for (size_t i = 0; i < count; i++) {
+		struct sc_view *view = hits[i]->data;
+		*surface = sc_view_surface_at(view, x, y, sx, sy);
+		if (*surface == NULL) {
+			continue;
+		}
+		// popups belong to the view that owns the grab and the focus
+		while (view->type == SC_VIEW_POPUP && view->parent != NULL) {
+			view = view->parent;
 		}
+		return view;
 	}
+	*surface = NULL;
 	return NULL;
 }
 
@@ -121,6 +243,7 @@ sc_composer_focus_view(struct sc_compositor *compositor, struct sc_view *view)
 		wl_list_remove(&toplevel->link);
 		wl_list_insert(&compositor->current_workspace->views_toplevel,
 					   &toplevel->link);
+		sc_view_raise(view);
 	}
 
 	sc_view_activate(compositor->current_view);
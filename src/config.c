@@ -24,10 +24,28 @@ static int handler(void* user, const char* section, const char* name,
         pconfig->display_refresh = atoi(value);
     } else if (MATCH("Display", "max_render_time")) {
         pconfig->max_render_time = atoi(value);
+    } else if (MATCH("Display", "adaptive_sync")) {
+        pconfig->adaptive_sync = atoi(value);
+    } else if (MATCH("Display", "vrr_min_refresh")) {
+        pconfig->vrr_min_refresh = atoi(value);
     } else if (MATCH("Display", "scale")) {
         pconfig->display_scale = atof(value);
     } else if (MATCH("Compositor", "shaders_path")) {
         pconfig->shaders_path = strdup(value);
+    } else if (MATCH("Compositor", "fbo_budget")) {
+        pconfig->fbo_budget = atoi(value);
+    } else if (MATCH("Compositor", "corner_radius")) {
+        pconfig->corner_radius = atoi(value);
+    } else if (MATCH("Compositor", "inactive_dim")) {
+        pconfig->inactive_dim = atof(value);
+    } else if (MATCH("Compositor", "log_level")) {
+        pconfig->log_level = strdup(value);
+    } else if (MATCH("Compositor", "workspaces")) {
+        pconfig->workspaces = atoi(value);
+    } else if (MATCH("Compositor", "thumbnail_rate")) {
+        pconfig->thumbnail_rate = atoi(value);
+    } else if (MATCH("Compositor", "low_latency_app_ids")) {
+        pconfig->low_latency_app_ids = strdup(value);
     } else {
         return 0;  /* unknown section/name, error */
     }
@@ -1,33 +1,101 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <time.h>
+#include <wlr/render/gles2.h>
+
+#include "gles2_renderer.h"
 #include "log.h"
 #include "sc_fbo.h"
 
-// #include "gles2_renderer.h"
-// #include <unistd.h>
-void gl_begin();
+#define SC_FBO_POOL_BUCKETS 32
+// idle framebuffers are freed after this long, however many outputs repaint
+#define SC_FBO_POOL_MAX_IDLE_MS 2000
 
-struct sc_fbo *
-fbo_create(int w, int h)
+struct sc_fbo_pool {
+	bool initialized;
+	struct wl_list buckets[SC_FBO_POOL_BUCKETS];
+	struct wl_list used;
+	struct sc_fbo_pool_stats stats;
+};
+
+static struct sc_fbo_pool pool;
+
+static uint32_t
+pool_now_ms()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t) (now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+static size_t
+fbo_bytes_per_pixel(GLenum format)
+{
+	switch (format) {
+	case GL_RGB:
+		return 3;
+	case GL_LUMINANCE_ALPHA:
+		return 2;
+	case GL_LUMINANCE:
+	case GL_ALPHA:
+		return 1;
+	default:
+		return 4;
+	}
+}
+
+static const char *
+fbo_status_string(GLenum status)
+{
+	switch (status) {
+	case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
+		return "GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT";
+	case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
+		return "GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT";
+	case GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS:
+		return "GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS";
+	case GL_FRAMEBUFFER_UNSUPPORTED:
+		return "GL_FRAMEBUFFER_UNSUPPORTED";
+	default:
+		return "unknown";
+	}
+}
+
+static struct sc_fbo *
+fbo_create(int w, int h, GLenum format)
 {
 	gl_begin();
+	if (w <= 0 || h <= 0) {
+		ELOG("fbo_create: invalid size %dx%d\n", w, h);
+		return NULL;
+	}
 	struct sc_fbo *fbo = (struct sc_fbo *) calloc(1, sizeof(struct sc_fbo));
+	if (fbo == NULL) {
+		return NULL;
+	}
 
-	LOG("fbo_create %dx%d\n", w, h);
+	DLOG("fbo_create %dx%d\n", w, h);
 	GLuint tex;
-    GLuint framebuffer;
+	GLuint framebuffer;
+
+	// drop stale errors so that the checks below only see ours
+	while (glGetError() != GL_NO_ERROR) {
+	}
 
 	glGenFramebuffers(1, &framebuffer);
-    LOG("%u\n", framebuffer);
-    fbo->framebuffer = framebuffer;
+	fbo->framebuffer = framebuffer;
 
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo->framebuffer);
 	glGenTextures(1, &tex);
 	fbo->tex = tex;
 	fbo->width = w;
 	fbo->height = h;
+	fbo->format = format;
+	fbo->size = (size_t) w * h * fbo_bytes_per_pixel(format);
+	wl_list_init(&fbo->link);
+
 	glBindTexture(GL_TEXTURE_2D, tex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+	glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE,
 				 NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -37,29 +105,204 @@ fbo_create(int w, int h)
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) {
+		ELOG("fbo_create: texture allocation failed %dx%d (0x%x)\n", w, h,
+			 error);
+		goto error;
+	}
+
 	// attach it to currently bound framebuffer object
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
 						   tex, 0);
 
-    GLenum fbstatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (fbstatus == GL_FRAMEBUFFER_COMPLETE) {
-		LOG("gen fbo good! %d\n", fbo->framebuffer);
-	} else {
-		LOG("fbo went wrong %d\n", fbstatus);
-        if(fbstatus == GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT) {
-            LOG("GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT\n");
-        }
-		if(fbstatus == GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT) {
-            LOG("GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT\n");
-        }
-		if(fbstatus == GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS) {
-            LOG("GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS\n");
-        }
-		if(fbstatus == GL_FRAMEBUFFER_UNSUPPORTED) {
-            LOG("GL_FRAMEBUFFER_UNSUPPORTED\n");
-        }
-        exit(1);
+	GLenum fbstatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (fbstatus != GL_FRAMEBUFFER_COMPLETE) {
+		ELOG("fbo went wrong %d %s\n", fbstatus, fbo_status_string(fbstatus));
+		goto error;
 	}
+	DLOG("gen fbo good! %d\n", fbo->framebuffer);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    return fbo;
+	return fbo;
+
+error:
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo->framebuffer);
+	glDeleteTextures(1, &fbo->tex);
+	free(fbo);
+	return NULL;
+}
+
+static void
+fbo_destroy(struct sc_fbo *fbo)
+{
+	if (fbo == NULL) {
+		return;
+	}
+	gl_begin();
+	glDeleteFramebuffers(1, &fbo->framebuffer);
+	glDeleteTextures(1, &fbo->tex);
+	free(fbo);
+}
+
+static void
+pool_init()
+{
+	if (pool.initialized) {
+		return;
+	}
+	for (int i = 0; i < SC_FBO_POOL_BUCKETS; i++) {
+		wl_list_init(&pool.buckets[i]);
+	}
+	wl_list_init(&pool.used);
+	pool.initialized = true;
+}
+
+static struct wl_list *
+pool_bucket(int w, int h, GLenum format)
+{
+	unsigned int hash = (unsigned int) w * 31u + (unsigned int) h;
+	hash = hash * 31u + (unsigned int) format;
+	return &pool.buckets[hash % SC_FBO_POOL_BUCKETS];
+}
+
+static void
+pool_free_fbo(struct sc_fbo *fbo)
+{
+	wl_list_remove(&fbo->link);
+	pool.stats.allocated -= fbo->size;
+	pool.stats.count--;
+	fbo_destroy(fbo);
+}
+
+/* frees the idle framebuffer unused for the longest time */
+static bool
+pool_evict_one()
+{
+	struct sc_fbo *oldest = NULL;
+	for (int i = 0; i < SC_FBO_POOL_BUCKETS; i++) {
+		struct sc_fbo *fbo;
+		wl_list_for_each (fbo, &pool.buckets[i], link) {
+			if (oldest == NULL ||
+				(int32_t) (fbo->idle_since - oldest->idle_since) < 0) {
+				oldest = fbo;
+			}
+		}
+	}
+	if (oldest == NULL) {
+		return false;
+	}
+	pool_free_fbo(oldest);
+	return true;
+}
+
+struct sc_fbo *
+sc_fbo_pool_acquire(int w, int h, GLenum format)
+{
+	pool_init();
+
+	struct sc_fbo *fbo;
+	wl_list_for_each (fbo, pool_bucket(w, h, format), link) {
+		if (fbo->width == w && fbo->height == h && fbo->format == format) {
+			wl_list_remove(&fbo->link);
+			pool.stats.hits++;
+			goto acquired;
+		}
+	}
+
+	pool.stats.misses++;
+	size_t size = (size_t) w * h * fbo_bytes_per_pixel(format);
+	if (pool.stats.budget > 0) {
+		while (pool.stats.allocated + size > pool.stats.budget &&
+			   pool_evict_one()) {
+		}
+		if (pool.stats.allocated + size > pool.stats.budget) {
+			ELOG("fbo pool: %dx%d doesn't fit the budget (%zu/%zu bytes)\n", w,
+				 h, pool.stats.allocated, pool.stats.budget);
+			pool.stats.failures++;
+			return NULL;
+		}
+	}
+
+	fbo = fbo_create(w, h, format);
+	if (fbo == NULL) {
+		// free what we can and try again once
+		if (!pool_evict_one() ||
+			(fbo = fbo_create(w, h, format)) == NULL) {
+			pool.stats.failures++;
+			return NULL;
+		}
+	}
+	pool.stats.allocated += fbo->size;
+	pool.stats.count++;
+
+acquired:
+	fbo->in_use = true;
+	pool.stats.in_use += fbo->size;
+	pool.stats.count_in_use++;
+	wl_list_insert(&pool.used, &fbo->link);
+	return fbo;
+}
+
+void
+sc_fbo_pool_release(struct sc_fbo *fbo)
+{
+	if (fbo == NULL) {
+		return;
+	}
+	if (!fbo->in_use) {
+		ELOG("fbo pool: releasing an fbo that is not in use\n");
+		return;
+	}
+	fbo->in_use = false;
+	fbo->idle_since = pool_now_ms();
+	pool.stats.in_use -= fbo->size;
+	pool.stats.count_in_use--;
+	wl_list_remove(&fbo->link);
+	wl_list_insert(pool_bucket(fbo->width, fbo->height, fbo->format),
+				   &fbo->link);
+
+	if (pool.stats.budget > 0) {
+		while (pool.stats.allocated > pool.stats.budget && pool_evict_one()) {
+		}
+	}
+}
+
+void
+sc_fbo_pool_set_budget(size_t bytes)
+{
+	pool_init();
+	pool.stats.budget = bytes;
+	if (bytes > 0) {
+		sc_fbo_pool_trim(bytes);
+	}
+}
+
+void
+sc_fbo_pool_frame_done()
+{
+	pool_init();
+	uint32_t now = pool_now_ms();
+	for (int i = 0; i < SC_FBO_POOL_BUCKETS; i++) {
+		struct sc_fbo *fbo, *tmp;
+		wl_list_for_each_safe (fbo, tmp, &pool.buckets[i], link) {
+			if (now - fbo->idle_since > SC_FBO_POOL_MAX_IDLE_MS) {
+				pool_free_fbo(fbo);
+			}
+		}
+	}
+}
+
+void
+sc_fbo_pool_trim(size_t max_bytes)
+{
+	pool_init();
+	while (pool.stats.allocated > max_bytes && pool_evict_one()) {
+	}
+}
+
+void
+sc_fbo_pool_get_stats(struct sc_fbo_pool_stats *stats)
+{
+	*stats = pool.stats;
 }
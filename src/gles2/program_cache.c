@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "sc_program_cache.h"
+
+#define SC_PROGRAM_CACHE_MAGIC 0x42504353 // "SCPB"
+
+struct sc_program_cache_header {
+	uint32_t magic;
+	uint32_t format;
+	uint32_t length;
+};
+
+static struct {
+	bool enabled;
+	char dir[PATH_MAX];
+	/* vendor, renderer and version, hashed into every key */
+	uint64_t driver_hash;
+	PFNGLGETPROGRAMBINARYOESPROC get_program_binary;
+	PFNGLPROGRAMBINARYOESPROC program_binary;
+} cache;
+
+static uint64_t
+fnv1a(uint64_t hash, const char *str)
+{
+	// the terminating zero is hashed too so "ab","c" and "a","bc" differ
+	do {
+		hash ^= (unsigned char) *str;
+		hash *= 0x100000001b3ULL;
+	} while (*str++);
+	return hash;
+}
+
+static bool
+cache_mkdir(const char *path)
+{
+	if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+		return false;
+	}
+	return true;
+}
+
+static bool
+cache_find_dir()
+{
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	char base[PATH_MAX];
+	if (xdg != NULL && xdg[0] != '\0') {
+		snprintf(base, sizeof(base), "%s", xdg);
+	} else if (home != NULL && home[0] != '\0') {
+		snprintf(base, sizeof(base), "%s/.cache", home);
+	} else {
+		return false;
+	}
+	snprintf(cache.dir, sizeof(cache.dir), "%s/screencomposer", base);
+	return cache_mkdir(base) && cache_mkdir(cache.dir);
+}
+
+bool
+sc_program_cache_init()
+{
+	const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+	if (extensions == NULL ||
+		strstr(extensions, "GL_OES_get_program_binary") == NULL) {
+		LOG("program cache: GL_OES_get_program_binary not supported\n");
+		return false;
+	}
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+	if (formats == 0) {
+		LOG("program cache: no program binary formats\n");
+		return false;
+	}
+
+	cache.get_program_binary = (PFNGLGETPROGRAMBINARYOESPROC)
+		eglGetProcAddress("glGetProgramBinaryOES");
+	cache.program_binary =
+		(PFNGLPROGRAMBINARYOESPROC) eglGetProcAddress("glProgramBinaryOES");
+	if (cache.get_program_binary == NULL || cache.program_binary == NULL) {
+		return false;
+	}
+	if (!cache_find_dir()) {
+		ELOG("program cache: can't create the cache directory\n");
+		return false;
+	}
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash = fnv1a(hash, (const char *) glGetString(GL_VENDOR));
+	hash = fnv1a(hash, (const char *) glGetString(GL_RENDERER));
+	hash = fnv1a(hash, (const char *) glGetString(GL_VERSION));
+	cache.driver_hash = hash;
+	cache.enabled = true;
+	DLOG("program cache: %s\n", cache.dir);
+	return true;
+}
+
+static void
+cache_path(char *path, size_t size, const char *vert_src,
+		   const char *frag_src)
+{
+	uint64_t hash = fnv1a(cache.driver_hash, vert_src);
+	hash = fnv1a(hash, frag_src);
+	snprintf(path, size, "%s/%016llx.bin", cache.dir,
+			 (unsigned long long) hash);
+}
+
+GLuint
+sc_program_cache_load(const char *vert_src, const char *frag_src)
+{
+	if (!cache.enabled) {
+		return 0;
+	}
+	char path[PATH_MAX];
+	cache_path(path, sizeof(path), vert_src, frag_src);
+
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return 0;
+	}
+	struct sc_program_cache_header header;
+	void *binary = NULL;
+	GLuint program = 0;
+	if (fread(&header, sizeof(header), 1, f) != 1 ||
+		header.magic != SC_PROGRAM_CACHE_MAGIC || header.length == 0) {
+		goto out;
+	}
+	binary = malloc(header.length);
+	if (binary == NULL || fread(binary, header.length, 1, f) != 1) {
+		goto out;
+	}
+
+	program = glCreateProgram();
+	cache.program_binary(program, header.format, binary, header.length);
+	GLint ok = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (ok == GL_FALSE) {
+		// the driver can refuse binaries at any time, the caller recompiles
+		DLOG("program cache: stale entry %s\n", path);
+		glDeleteProgram(program);
+		program = 0;
+		unlink(path);
+	}
+
+out:
+	free(binary);
+	fclose(f);
+	return program;
+}
+
+void
+sc_program_cache_store(GLuint program, const char *vert_src,
+					   const char *frag_src)
+{
+	if (!cache.enabled) {
+		return;
+	}
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+	if (length <= 0) {
+		return;
+	}
+	void *binary = malloc(length);
+	if (binary == NULL) {
+		return;
+	}
+	struct sc_program_cache_header header = {
+		.magic = SC_PROGRAM_CACHE_MAGIC,
+	};
+	GLsizei written = 0;
+	GLenum format = 0;
+	cache.get_program_binary(program, length, &written, &format, binary);
+	if (written <= 0) {
+		free(binary);
+		return;
+	}
+	header.format = format;
+	header.length = written;
+
+	// write then rename, a crash never leaves a truncated entry behind
+	char path[PATH_MAX];
+	char tmp[PATH_MAX + 8];
+	cache_path(path, sizeof(path), vert_src, frag_src);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	FILE *f = fopen(tmp, "wb");
+	if (f == NULL) {
+		free(binary);
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+			  fwrite(binary, written, 1, f) == 1;
+	ok = fclose(f) == 0 && ok;
+	if (!ok || rename(tmp, path) < 0) {
+		ELOG("program cache: can't write %s\n", path);
+		unlink(tmp);
+	}
+	free(binary);
+}
@@ -1,39 +1,93 @@
 #define _POSIX_C_SOURCE 200809L
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/gles2.h>
 #include <wlr/types/wlr_matrix.h>
+#include <wlr/util/box.h>
 
 #include "log.h"
+#include "sc_color_matrix.h"
+#include "sc_gl_state.h"
 #include "sc_output.h"
+#include "sc_program_cache.h"
 #include "sc_shader.h"
+#include "sc_sync.h"
 
-static const GLfloat texcoord[] = {
-	1, 0, // top right
-	0, 0, // top left
-	1, 1, // bottom right
-	0, 1, // bottom left
+static const float flip_180[9] = {
+	1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
 };
 
-static const GLfloat verts[] = {
+/* unit quad corners, as two triangles */
+static const GLfloat quad_corners[] = {
 	1, 0, // top right
 	0, 0, // top left
 	1, 1, // bottom right
+	1, 1, // bottom right
+	0, 0, // top left
 	0, 1, // bottom left
 };
 
-static const float flip_180[9] = {
-	1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+#define SC_QUAD_VERTICES 6
+
+struct sc_quad_vertex {
+	GLfloat x, y;
+	GLfloat u, v;
+	GLfloat alpha;
+};
+
+static GLuint vbo_stream;
+
+/* texture shader variants, built on first use */
+static struct sc_shader *texture_shaders[SC_SHADER_VARIANT_COUNT];
+static bool texture_shader_failed[SC_SHADER_VARIANT_COUNT];
+
+/* built at startup, what nearly every frame uses */
+static const uint32_t prewarm_variants[] = {
+	0,
+	SC_SHADER_ALPHA,
+	SC_SHADER_ALPHA | SC_SHADER_OPACITY,
+	SC_SHADER_EXTERNAL | SC_SHADER_ALPHA,
 };
 
-static GLuint vbo_vert;
-static GLuint vbo_texcoord;
+// how many pending draws a draw can be pulled forward across
+#define SC_RENDER_MAX_LOOKAHEAD 32
+
+struct sc_render_draw {
+	struct sc_shader *shader;
+	GLenum target;
+	GLuint tex;
+	/* output space footprint, used to keep overlapping draws in order */
+	struct wlr_box box;
+	float matrix[9];
+	struct wlr_fbox uv;
+	float alpha;
+	/* rounded clip uniforms, only for SC_SHADER_ROUNDED */
+	float clip_transform[4];
+	float clip_shape[3];
+	/* only for SC_SHADER_COLOR_MATRIX */
+	struct sc_color_matrix color_matrix;
+	bool emitted;
+};
+
+struct sc_render_queue {
+	struct sc_render_draw *draws;
+	size_t len;
+	size_t cap;
+	struct wlr_box skipped[SC_RENDER_MAX_LOOKAHEAD];
+
+	/* draws in submission order and their expanded vertices */
+	struct sc_render_draw **order;
+	size_t order_len;
+	size_t order_cap;
+	struct sc_quad_vertex *vertices;
+	size_t vertices_cap;
+};
 
-static struct sc_shader *shader_texture_rgba;
-static struct sc_shader *shader_texture_rgbx;
-static struct sc_shader *shader_texture_external;
+static struct sc_render_queue queue;
 
 extern struct sc_compositor *compositor;
 
@@ -47,108 +101,276 @@ gl_begin()
 	}
 }
 
-void
+static struct sc_shader *
+texture_shader(uint32_t variant)
+{
+	if (texture_shaders[variant] == NULL && !texture_shader_failed[variant]) {
+		texture_shaders[variant] = sc_shader_create_variant("texture", variant);
+		// don't retry a broken variant every frame
+		texture_shader_failed[variant] = texture_shaders[variant] == NULL;
+	}
+	return texture_shaders[variant];
+}
+
+bool
 sc_renderer_load_shaders()
 {
 	gl_begin();
-	shader_texture_rgba = sc_shader_create("textureRGBA");
-	shader_texture_rgbx = sc_shader_create("textureRGBX");
-	shader_texture_external = sc_shader_create("textureExternal");
-
-	/* Load vertex buffers for the shaders */
-
-	GLuint buffers[2];
-	glGenBuffers(2, buffers);
-
-	vbo_vert = buffers[0];
-	vbo_texcoord = buffers[1];
-
-	const int VERTEX_BUFFER_SIZE = 8;
-	const int VERTEX_BUFFER_BYTESIZE = sizeof(GLfloat) * VERTEX_BUFFER_SIZE;
-
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vert);
-	glBufferData(GL_ARRAY_BUFFER, VERTEX_BUFFER_BYTESIZE, verts,
-				 GL_STATIC_DRAW);
+	sc_program_cache_init();
+	sc_sync_init();
+	for (size_t i = 0;
+		 i < sizeof(prewarm_variants) / sizeof(prewarm_variants[0]); i++) {
+		if (texture_shader(prewarm_variants[i]) == NULL) {
+			return false;
+		}
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_texcoord);
-	glBufferData(GL_ARRAY_BUFFER, VERTEX_BUFFER_BYTESIZE, texcoord,
-				 GL_STATIC_DRAW);
+	/* quads are expanded on the cpu and streamed every frame */
+	glGenBuffers(1, &vbo_stream);
+	return true;
 }
 
 struct sc_shader *
-shader_for_texattribs(struct wlr_gles2_texture_attribs *attribs)
+shader_for_texattribs(struct wlr_gles2_texture_attribs *attribs, float alpha,
+					  bool rounded, bool color_matrix)
 {
-	struct sc_shader *shader;
+	uint32_t variant = 0;
 	switch (attribs->target) {
 	case GL_TEXTURE_2D:
-		if (attribs->has_alpha) {
-			shader = shader_texture_rgba;
-		} else {
-			shader = shader_texture_rgbx;
-		}
 		break;
 	case GL_TEXTURE_EXTERNAL_OES:
-		shader = shader_texture_external;
+		variant |= SC_SHADER_EXTERNAL;
 		break;
 	default:
 		ELOG("error: can't find shader for texture attributes...\n");
-		shader = shader_texture_rgba;
+		return NULL;
+	}
+	if (attribs->has_alpha) {
+		variant |= SC_SHADER_ALPHA;
+	}
+	if (alpha < 1.0f) {
+		variant |= SC_SHADER_OPACITY;
 	}
+	if (rounded) {
+		variant |= SC_SHADER_ROUNDED;
+	}
+	if (color_matrix) {
+		variant |= SC_SHADER_COLOR_MATRIX;
+	}
+	return texture_shader(variant);
+}
 
-	return shader;
+static bool
+render_draws_batchable(struct sc_render_draw *a, struct sc_render_draw *b)
+{
+	return a->shader == b->shader && a->target == b->target;
 }
 
-void
-render_texture_with_matrix(struct wlr_gles2_texture_attribs *texture, int sx,
-						   int sy, int w, int h, float *matrix)
+static bool
+render_draws_same_texture(struct sc_render_draw *a, struct sc_render_draw *b)
 {
-	struct sc_shader *shader = shader_for_texattribs(texture);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(texture->target, texture->tex);
-	glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	if (!render_draws_batchable(a, b) || a->tex != b->tex) {
+		return false;
+	}
+	// the clip and the color matrix are uniforms, each one is its own call
+	if ((a->shader->variant & SC_SHADER_COLOR_MATRIX) &&
+		memcmp(&a->color_matrix, &b->color_matrix,
+			   sizeof(a->color_matrix)) != 0) {
+		return false;
+	}
+	return !(a->shader->variant & SC_SHADER_ROUNDED) ||
+		   (memcmp(a->clip_transform, b->clip_transform,
+				   sizeof(a->clip_transform)) == 0 &&
+			memcmp(a->clip_shape, b->clip_shape, sizeof(a->clip_shape)) == 0);
+}
 
-	glActiveTexture(GL_TEXTURE0 + 1);
+static bool
+render_box_overlaps_skipped(struct wlr_box *box, size_t skipped)
+{
+	struct wlr_box intersection;
+	for (size_t k = 0; k < skipped; k++) {
+		if (wlr_box_intersection(&intersection, box, &queue.skipped[k])) {
+			return true;
+		}
+	}
+	return false;
+}
 
-	sc_shader_begin(shader);
-	// uniformsForShader(shader);
+static void
+render_queue_emit(struct sc_render_draw *draw)
+{
+	queue.order[queue.order_len++] = draw;
+	draw->emitted = true;
+}
+
+static bool
+render_queue_reserve(size_t draws)
+{
+	if (queue.order_cap < draws) {
+		struct sc_render_draw **order =
+			realloc(queue.order, draws * sizeof(struct sc_render_draw *));
+		if (order == NULL) {
+			return false;
+		}
+		queue.order = order;
+		queue.order_cap = draws;
+	}
+	size_t vertices = draws * SC_QUAD_VERTICES;
+	if (queue.vertices_cap < vertices) {
+		struct sc_quad_vertex *v =
+			realloc(queue.vertices, vertices * sizeof(struct sc_quad_vertex));
+		if (v == NULL) {
+			return false;
+		}
+		queue.vertices = v;
+		queue.vertices_cap = vertices;
+	}
+	return true;
+}
 
-	glUniformMatrix3fv(shader->proj, 1, GL_FALSE, matrix);
-	//  glUniform1i(shader->invert_y, texture->inverted_y);
-	glUniform1i(shader->tex, 0);
-	glUniform1f(shader->alpha, 1.0);
-	glUniform3f(shader->texsize, w, h, 0);
-	glUniform3f(shader->texpos, sx, sy, 0);
+/* transforms the unit quad with the draw matrix, straight to clip space */
+static void
+render_draw_write_vertices(struct sc_render_draw *draw,
+						   struct sc_quad_vertex *out)
+{
+	// the matrix is transposed, column major as GL expects it
+	const float *m = draw->matrix;
+	for (int i = 0; i < SC_QUAD_VERTICES; i++) {
+		GLfloat cx = quad_corners[i * 2];
+		GLfloat cy = quad_corners[i * 2 + 1];
+		out[i].x = m[0] * cx + m[3] * cy + m[6];
+		out[i].y = m[1] * cx + m[4] * cy + m[7];
+		out[i].u = draw->uv.x + cx * draw->uv.width;
+		out[i].v = draw->uv.y + cy * draw->uv.height;
+		out[i].alpha = draw->alpha;
+	}
+}
+
+static void
+render_draw_run(struct sc_render_draw *draw, size_t first, size_t count)
+{
+	struct sc_shader *shader = draw->shader;
+
+	sc_gl_active_texture(GL_TEXTURE0);
+	sc_gl_bind_texture(draw->target, draw->tex);
+	sc_gl_tex_min_filter(draw->target, draw->tex, GL_LINEAR);
 
-	glEnableVertexAttribArray(shader->pos_attrib);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vert);
-	glVertexAttribPointer(shader->pos_attrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	sc_shader_begin(shader);
+	sc_shader_set_tex(shader, 0);
+	if (shader->variant & SC_SHADER_ROUNDED) {
+		sc_shader_set_clip(shader, draw->clip_transform, draw->clip_shape);
+	}
+	if (shader->variant & SC_SHADER_COLOR_MATRIX) {
+		sc_shader_set_color_matrix(shader, draw->color_matrix.matrix,
+								   draw->color_matrix.offset);
+	}
 
-	glEnableVertexAttribArray(shader->tex_attrib);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_texcoord);
-	glVertexAttribPointer(shader->tex_attrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	const GLsizei stride = sizeof(struct sc_quad_vertex);
+	sc_gl_enable_vertex_attrib_array(shader->pos_attrib);
+	glVertexAttribPointer(shader->pos_attrib, 2, GL_FLOAT, GL_FALSE, stride,
+						  (void *) offsetof(struct sc_quad_vertex, x));
+	sc_gl_enable_vertex_attrib_array(shader->tex_attrib);
+	glVertexAttribPointer(shader->tex_attrib, 2, GL_FLOAT, GL_FALSE, stride,
+						  (void *) offsetof(struct sc_quad_vertex, u));
+	if (shader->variant & SC_SHADER_OPACITY) {
+		sc_gl_enable_vertex_attrib_array(shader->alpha_attrib);
+		glVertexAttribPointer(shader->alpha_attrib, 1, GL_FLOAT, GL_FALSE,
+							  stride,
+							  (void *) offsetof(struct sc_quad_vertex, alpha));
+	}
+	// opaque and fully visible, nothing to blend with
+	sc_gl_set_blend(shader->variant &
+					(SC_SHADER_ALPHA | SC_SHADER_OPACITY | SC_SHADER_ROUNDED |
+					 SC_SHADER_COLOR_MATRIX));
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glDrawArrays(GL_TRIANGLES, first * SC_QUAD_VERTICES,
+				 count * SC_QUAD_VERTICES);
+}
 
-	// glDisableVertexAttribArray(shader->pos_attrib);
-	// glDisableVertexAttribArray(shader->tex_attrib);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void
+sc_renderer_begin()
+{
+	// wlroots or skia may have used the context since the last frame
+	sc_gl_state_invalidate();
+	queue.len = 0;
 }
 
+/*
+ * Submits the queued draws. Draws using the same shader are pulled forward
+ * next to each other unless they overlap a draw that is still pending, so the
+ * painter's order stays correct where it matters. The quads are then written
+ * into a single streaming buffer and every run sharing a texture is issued
+ * with one draw call.
+ */
 void
-sc_render_texture_with_output(struct wlr_gles2_texture_attribs *texture, int sx,
-							  int sy, int w, int h, enum wl_output_transform t,
-							  struct sc_output *output)
+sc_renderer_flush()
 {
+	if (queue.len == 0) {
+		return;
+	}
+	if (!render_queue_reserve(queue.len)) {
+		ELOG("error: unable to allocate the draw batch\n");
+		queue.len = 0;
+		return;
+	}
+	queue.order_len = 0;
 
-	// double ox = output->output_box->x;
-	// double oy = output->output_box->y;
+	for (size_t i = 0; i < queue.len; i++) {
+		struct sc_render_draw *draw = &queue.draws[i];
+		if (draw->emitted) {
+			continue;
+		}
+		render_queue_emit(draw);
+
+		size_t skipped = 0;
+		for (size_t j = i + 1;
+			 j < queue.len && skipped < SC_RENDER_MAX_LOOKAHEAD; j++) {
+			struct sc_render_draw *next = &queue.draws[j];
+			if (next->emitted) {
+				continue;
+			}
+			if (render_draws_batchable(draw, next) &&
+				!render_box_overlaps_skipped(&next->box, skipped)) {
+				render_queue_emit(next);
+			} else {
+				queue.skipped[skipped++] = next->box;
+			}
+		}
+	}
 
-	//  struct wlr_output *o = output->wlr_output;
-	//	wlr_output_layout_output_coords(output->layout, o, &ox, &oy);
+	for (size_t i = 0; i < queue.order_len; i++) {
+		render_draw_write_vertices(queue.order[i],
+								   &queue.vertices[i * SC_QUAD_VERTICES]);
+	}
+	sc_gl_bind_buffer(GL_ARRAY_BUFFER, vbo_stream);
+	// respecifying the whole store lets the driver orphan the old one
+	glBufferData(GL_ARRAY_BUFFER,
+				 queue.order_len * SC_QUAD_VERTICES *
+					 sizeof(struct sc_quad_vertex),
+				 queue.vertices, GL_STREAM_DRAW);
+
+	size_t first = 0;
+	for (size_t i = 1; i <= queue.order_len; i++) {
+		if (i < queue.order_len &&
+			render_draws_same_texture(queue.order[first], queue.order[i])) {
+			continue;
+		}
+		render_draw_run(queue.order[first], first, i - first);
+		first = i;
+	}
 
-	// ox += sx;
-	// oy += sy;
+	queue.len = 0;
+	sc_gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+	sc_gl_set_blend(true);
+}
 
+void
+sc_render_texture_region_with_projection(
+	struct wlr_gles2_texture_attribs *texture, const struct wlr_fbox *uv,
+	int sx, int sy, int w, int h, enum wl_output_transform t, float alpha,
+	float corner_radius, const struct sc_color_matrix *color_matrix,
+	const float projection[static 9])
+{
 	struct wlr_box box = {
 		.x = sx,
 		.y = sy,
@@ -156,17 +378,88 @@ sc_render_texture_with_output(struct wlr_gles2_texture_attribs *texture, int sx,
 		.height = h,
 	};
 
-	float output_transform_matrix[9];
-	wlr_matrix_identity(output_transform_matrix);
-
 	float gl_matrix[9];
 	enum wl_output_transform transform = wlr_output_transform_invert(t);
-	wlr_matrix_project_box(gl_matrix, &box, transform, 0,
-						   output->projection_matrix);
+	wlr_matrix_project_box(gl_matrix, &box, transform, 0, projection);
 
 	wlr_matrix_multiply(gl_matrix, flip_180, gl_matrix);
 
 	wlr_matrix_transpose(gl_matrix, gl_matrix);
 
-	render_texture_with_matrix(texture, sx, sy, w, h, gl_matrix);
+	struct sc_shader *shader = shader_for_texattribs(
+		texture, alpha, corner_radius > 0.0f, color_matrix != NULL);
+	if (shader == NULL) {
+		return;
+	}
+	if (queue.len == queue.cap) {
+		size_t cap = queue.cap == 0 ? 64 : queue.cap * 2;
+		struct sc_render_draw *draws =
+			realloc(queue.draws, cap * sizeof(struct sc_render_draw));
+		if (draws == NULL) {
+			ELOG("error: unable to grow the draw queue\n");
+			return;
+		}
+		queue.draws = draws;
+		queue.cap = cap;
+	}
+	struct sc_render_draw *draw = &queue.draws[queue.len++];
+	draw->shader = shader;
+	draw->target = texture->target;
+	draw->tex = texture->tex;
+	draw->box = box;
+	if (t & WL_OUTPUT_TRANSFORM_90) {
+		// rotated around the center, keep a conservative footprint
+		int size = w > h ? w : h;
+		draw->box.x -= (size - w) / 2 + 1;
+		draw->box.y -= (size - h) / 2 + 1;
+		draw->box.width = size + 2;
+		draw->box.height = size + 2;
+	}
+	memcpy(draw->matrix, gl_matrix, sizeof(gl_matrix));
+	if (uv != NULL) {
+		draw->uv = *uv;
+	} else {
+		draw->uv = (struct wlr_fbox){.x = 0, .y = 0, .width = 1, .height = 1};
+	}
+	draw->alpha = alpha;
+	if (corner_radius > 0.0f) {
+		// the shader clips in texcoord space, which is the buffer's
+		float bw = (t & WL_OUTPUT_TRANSFORM_90) ? h : w;
+		float bh = (t & WL_OUTPUT_TRANSFORM_90) ? w : h;
+		float max_radius = (bw < bh ? bw : bh) / 2.0f;
+		draw->clip_transform[0] = draw->uv.x;
+		draw->clip_transform[1] = draw->uv.y;
+		draw->clip_transform[2] = bw / draw->uv.width;
+		draw->clip_transform[3] = bh / draw->uv.height;
+		draw->clip_shape[0] = bw / 2.0f;
+		draw->clip_shape[1] = bh / 2.0f;
+		draw->clip_shape[2] =
+			corner_radius < max_radius ? corner_radius : max_radius;
+	}
+	if (color_matrix != NULL) {
+		draw->color_matrix = *color_matrix;
+	}
+	draw->emitted = false;
+}
+
+void
+sc_render_texture_region_with_output(struct wlr_gles2_texture_attribs *texture,
+									 const struct wlr_fbox *uv, int sx, int sy,
+									 int w, int h, enum wl_output_transform t,
+									 float alpha, float corner_radius,
+									 const struct sc_color_matrix *color_matrix,
+									 struct sc_output *output)
+{
+	sc_render_texture_region_with_projection(texture, uv, sx, sy, w, h, t,
+											 alpha, corner_radius, color_matrix,
+											 output->projection_matrix);
+}
+
+void
+sc_render_texture_with_output(struct wlr_gles2_texture_attribs *texture, int sx,
+							  int sy, int w, int h, enum wl_output_transform t,
+							  struct sc_output *output)
+{
+	sc_render_texture_region_with_output(texture, NULL, sx, sy, w, h, t, 1.0f,
+										 0.0f, NULL, output);
 }
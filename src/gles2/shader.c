@@ -2,9 +2,13 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "log.h"
 #include "sc_config.h"
+#include "sc_gl_state.h"
+#include "sc_program_cache.h"
 #include "sc_shader.h"
 #include "utils.h"
 
@@ -87,7 +91,13 @@ shader_link(struct sc_shader *shader, const char *vert_src,
   glGetProgramiv(shader->program, GL_LINK_STATUS, &ok);
   if (ok == GL_FALSE)
     {
+      GLsizei log_length = 0;
+      GLchar  message[1024];
+      glGetProgramInfoLog(shader->program, 1024, &log_length, message);
+      ELOG("error linking:\n%s\n", message);
+
       glDeleteProgram(shader->program);
+      shader->program = 0;
       goto error;
     }
   DLOG("program linked succesfully\n");
@@ -106,32 +116,205 @@ void shader_setup_default_uniforms(struct sc_shader *shader)
   shader->invert_y = glGetUniformLocation(shader->program, "invert_y");
   shader->texsize = glGetUniformLocation(shader->program, "texsize");
   shader->texpos = glGetUniformLocation(shader->program, "texpos");
+  shader->color_matrix = glGetUniformLocation(shader->program, "color_matrix");
+  shader->color_offset = glGetUniformLocation(shader->program, "color_offset");
+  shader->clip_transform =
+    glGetUniformLocation(shader->program, "clip_transform");
+  shader->clip_shape = glGetUniformLocation(shader->program, "clip_shape");
   shader->tex = glGetUniformLocation(shader->program, "tex");
   shader->pos_attrib = glGetAttribLocation(shader->program, "pos");
   shader->tex_attrib = glGetAttribLocation(shader->program, "texcoord");
+  shader->alpha_attrib = glGetAttribLocation(shader->program, "quad_alpha");
 
 }
 
+/* returns an allocated copy of shaders/<filename> */
+static char *
+shader_read_source(const char *filename)
+{
+	if (configuration.shaders_path != NULL) {
+		char *path = asprintf("%s/%s", configuration.shaders_path, filename);
+		if (access(path, R_OK) == 0) {
+			LOG("shader: using %s\n", path);
+			char *source = (char *)sc_read_file(path);
+			free(path);
+			return source;
+		}
+		free(path);
+	}
+	for (const struct sc_shader_source *s = sc_shader_sources; s->name; s++) {
+		if (strcmp(s->name, filename) == 0) {
+			return strdup(s->source);
+		}
+	}
+	ELOG("error: no source for shader %s\n", filename);
+	return NULL;
+}
+
+static const char *variant_defines[] = {
+	"#define SC_ALPHA 1\n",
+	"#define SC_OPACITY 1\n",
+	"#define SC_EXTERNAL 1\n",
+	"#define SC_STRAIGHT_ALPHA 1\n",
+	"#define SC_COLOR_MATRIX 1\n",
+	"#define SC_ROUNDED 1\n",
+};
+
+/* prepends the variant defines to source, which is freed */
+static char *
+shader_specialize(char *source, uint32_t variant)
+{
+	if (source == NULL || variant == 0) {
+		return source;
+	}
+	size_t len = strlen(source) + 1;
+	for (size_t i = 0; i < sizeof(variant_defines) / sizeof(char *); i++) {
+		if (variant & (1u << i)) {
+			len += strlen(variant_defines[i]);
+		}
+	}
+	char *specialized = malloc(len);
+	if (specialized == NULL) {
+		free(source);
+		return NULL;
+	}
+	specialized[0] = '\0';
+	for (size_t i = 0; i < sizeof(variant_defines) / sizeof(char *); i++) {
+		if (variant & (1u << i)) {
+			strcat(specialized, variant_defines[i]);
+		}
+	}
+	strcat(specialized, source);
+	free(source);
+	return specialized;
+}
+
 struct sc_shader *
 sc_shader_create(const char *name)
 {
-	DLOG("sc_shader_create: %s\n", name);
-	struct sc_shader *shader = calloc(1, sizeof(struct sc_shader));
-	char *fragname = asprintf("%s/%s.frag", configuration.shaders_path, name);
-	const char *fragment_src = sc_read_file(fragname);
-	char *vertname = asprintf("%s/%s.vert", configuration.shaders_path, name);
-	const char *vertex_src = sc_read_file(vertname);
-	shader_link(shader, vertex_src, fragment_src);
+	return sc_shader_create_variant(name, 0);
+}
+
+struct sc_shader *
+sc_shader_create_variant(const char *name, uint32_t variant)
+{
+	DLOG("sc_shader_create: %s variant 0x%x\n", name, variant);
+	struct sc_shader *shader = NULL;
+	char *fragname = asprintf("%s.frag", name);
+	char *fragment_src =
+		shader_specialize(shader_read_source(fragname), variant);
+	char *vertname = asprintf("%s.vert", name);
+	char *vertex_src = shader_specialize(shader_read_source(vertname), variant);
+	if (fragment_src == NULL || vertex_src == NULL) {
+		goto out;
+	}
+
+	shader = calloc(1, sizeof(struct sc_shader));
+	shader->variant = variant;
+	shader->program = sc_program_cache_load(vertex_src, fragment_src);
+	if (shader->program == 0) {
+		shader_link(shader, vertex_src, fragment_src);
+		if (shader->program == 0) {
+			ELOG("error: can't build shader %s\n", name);
+			free(shader);
+			shader = NULL;
+			goto out;
+		}
+		sc_program_cache_store(shader->program, vertex_src, fragment_src);
+	}
 	shader_setup_default_uniforms(shader);
 
-	free((void *)fragname);
-	free((void *)vertname);
-	free((void *)fragment_src);
-	free((void *)vertex_src);
+out:
+	free(fragname);
+	free(vertname);
+	free(fragment_src);
+	free(vertex_src);
 	return shader;
 }
 
 void sc_shader_begin(struct sc_shader *shader)
 {
-  glUseProgram(shader->program);
+  sc_gl_use_program(shader->program);
+}
+
+/* the setters expect the shader program to be in use */
+void sc_shader_set_proj(struct sc_shader *shader, const GLfloat *matrix)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (memcmp(u->proj, matrix, sizeof(u->proj)) == 0)
+    {
+      return;
+    }
+  glUniformMatrix3fv(shader->proj, 1, GL_FALSE, matrix);
+  memcpy(u->proj, matrix, sizeof(u->proj));
+}
+
+void sc_shader_set_alpha(struct sc_shader *shader, GLfloat alpha)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (u->alpha == alpha)
+    {
+      return;
+    }
+  glUniform1f(shader->alpha, alpha);
+  u->alpha = alpha;
+}
+
+void sc_shader_set_tex(struct sc_shader *shader, GLint unit)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (u->tex == unit)
+    {
+      return;
+    }
+  glUniform1i(shader->tex, unit);
+  u->tex = unit;
+}
+
+void sc_shader_set_texsize(struct sc_shader *shader, GLfloat w, GLfloat h)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (u->texsize[0] == w && u->texsize[1] == h)
+    {
+      return;
+    }
+  glUniform3f(shader->texsize, w, h, 0);
+  u->texsize[0] = w;
+  u->texsize[1] = h;
+}
+
+void sc_shader_set_texpos(struct sc_shader *shader, GLfloat x, GLfloat y)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (u->texpos[0] == x && u->texpos[1] == y)
+    {
+      return;
+    }
+  glUniform3f(shader->texpos, x, y, 0);
+  u->texpos[0] = x;
+  u->texpos[1] = y;
+}
+
+void sc_shader_set_clip(struct sc_shader *shader, const GLfloat *transform,
+                        const GLfloat *shape)
+{
+  struct sc_shader_uniforms *u = &shader->uniforms;
+  if (memcmp(u->clip_transform, transform, sizeof(u->clip_transform)) != 0)
+    {
+      glUniform4fv(shader->clip_transform, 1, transform);
+      memcpy(u->clip_transform, transform, sizeof(u->clip_transform));
+    }
+  if (memcmp(u->clip_shape, shape, sizeof(u->clip_shape)) != 0)
+    {
+      glUniform3fv(shader->clip_shape, 1, shape);
+      memcpy(u->clip_shape, shape, sizeof(u->clip_shape));
+    }
+}
+
+void sc_shader_set_color_matrix(struct sc_shader *shader, const GLfloat *matrix,
+                                const GLfloat *offset)
+{
+  // not cached, set once per draw that needs it
+  glUniformMatrix4fv(shader->color_matrix, 1, GL_FALSE, matrix);
+  glUniform4fv(shader->color_offset, 1, offset);
 }
@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+
+#include "sc_gl_state.h"
+
+#define SC_GL_MAX_ATTRIBS 8
+#define SC_GL_FILTER_CACHE_SIZE 64
+
+struct sc_gl_filter_entry {
+	GLenum target;
+	GLuint tex;
+	GLint filter;
+};
+
+struct sc_gl_state {
+	bool valid;
+	GLuint program;
+	GLenum active_texture;
+	GLenum texture_target;
+	GLuint texture;
+	GLuint array_buffer;
+	GLuint element_buffer;
+	/* 0 unknown, 1 disabled, 2 enabled */
+	int blend;
+	bool attribs[SC_GL_MAX_ATTRIBS];
+	struct sc_gl_filter_entry filters[SC_GL_FILTER_CACHE_SIZE];
+};
+
+static struct sc_gl_state state;
+
+void
+sc_gl_state_invalidate()
+{
+	memset(&state, 0, sizeof(state));
+}
+
+void
+sc_gl_use_program(GLuint program)
+{
+	if (state.valid && state.program == program) {
+		return;
+	}
+	glUseProgram(program);
+	state.program = program;
+	state.valid = true;
+}
+
+void
+sc_gl_active_texture(GLenum unit)
+{
+	if (state.active_texture == unit) {
+		return;
+	}
+	glActiveTexture(unit);
+	state.active_texture = unit;
+	// the binding cache only tracks a single unit
+	state.texture = 0;
+	state.texture_target = 0;
+}
+
+void
+sc_gl_bind_texture(GLenum target, GLuint tex)
+{
+	if (state.active_texture != 0 && state.texture_target == target &&
+		state.texture == tex) {
+		return;
+	}
+	glBindTexture(target, tex);
+	state.texture_target = target;
+	state.texture = tex;
+}
+
+void
+sc_gl_bind_buffer(GLenum target, GLuint buffer)
+{
+	GLuint *cached = target == GL_ARRAY_BUFFER ? &state.array_buffer
+											   : &state.element_buffer;
+	// 0 means unknown, binding 0 is always forwarded
+	if (buffer != 0 && *cached == buffer) {
+		return;
+	}
+	glBindBuffer(target, buffer);
+	*cached = buffer;
+}
+
+void
+sc_gl_enable_vertex_attrib_array(GLuint index)
+{
+	if (index < SC_GL_MAX_ATTRIBS && state.attribs[index]) {
+		return;
+	}
+	glEnableVertexAttribArray(index);
+	if (index < SC_GL_MAX_ATTRIBS) {
+		state.attribs[index] = true;
+	}
+}
+
+void
+sc_gl_tex_min_filter(GLenum target, GLuint tex, GLint filter)
+{
+	struct sc_gl_filter_entry *entry =
+		&state.filters[tex % SC_GL_FILTER_CACHE_SIZE];
+	if (entry->tex == tex && entry->target == target &&
+		entry->filter == filter) {
+		return;
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+	entry->target = target;
+	entry->tex = tex;
+	entry->filter = filter;
+}
+
+void
+sc_gl_set_blend(bool enabled)
+{
+	int blend = enabled ? 2 : 1;
+	if (state.blend == blend) {
+		return;
+	}
+	if (enabled) {
+		glEnable(GL_BLEND);
+	} else {
+		glDisable(GL_BLEND);
+	}
+	state.blend = blend;
+}
@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200809L
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <errno.h>
+#include <linux/dma-buf.h>
+#include <linux/sync_file.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_surface.h>
+#include <wlr/util/addon.h>
+
+#include "log.h"
+#include "sc_sync.h"
+
+struct sc_sync_surface {
+	struct wlr_addon addon;
+	/* the writes of the client to the last committed buffer, or -1 */
+	int acquire_fd;
+};
+
+static struct {
+	bool enabled;
+	EGLDisplay display;
+	PFNEGLCREATESYNCKHRPROC create_sync;
+	PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+	PFNEGLWAITSYNCKHRPROC wait_sync;
+	PFNEGLDUPNATIVEFENCEFDANDROIDPROC dup_native_fence_fd;
+} sync;
+
+static int
+sync_ioctl(int fd, unsigned long request, void *arg)
+{
+	int ret;
+	do {
+		ret = ioctl(fd, request, arg);
+	} while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+	return ret;
+}
+
+/* the ioctls are missing before linux 6.0, there's no point trying again */
+static void
+sync_disable(const char *what)
+{
+	if (errno == ENOTTY || errno == EINVAL) {
+		LOG("sync: %s not supported, implicit sync only\n", what);
+		sync.enabled = false;
+	}
+}
+
+bool
+sc_sync_init()
+{
+#if defined(DMA_BUF_IOCTL_EXPORT_SYNC_FILE) &&                                 \
+	defined(DMA_BUF_IOCTL_IMPORT_SYNC_FILE)
+	sync.display = eglGetCurrentDisplay();
+	if (sync.display == EGL_NO_DISPLAY) {
+		return false;
+	}
+	const char *extensions = eglQueryString(sync.display, EGL_EXTENSIONS);
+	if (extensions == NULL ||
+		strstr(extensions, "EGL_ANDROID_native_fence_sync") == NULL ||
+		strstr(extensions, "EGL_KHR_wait_sync") == NULL) {
+		LOG("sync: EGL_ANDROID_native_fence_sync not supported\n");
+		return false;
+	}
+	sync.create_sync =
+		(PFNEGLCREATESYNCKHRPROC) eglGetProcAddress("eglCreateSyncKHR");
+	sync.destroy_sync =
+		(PFNEGLDESTROYSYNCKHRPROC) eglGetProcAddress("eglDestroySyncKHR");
+	sync.wait_sync =
+		(PFNEGLWAITSYNCKHRPROC) eglGetProcAddress("eglWaitSyncKHR");
+	sync.dup_native_fence_fd = (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)
+		eglGetProcAddress("eglDupNativeFenceFDANDROID");
+	if (sync.create_sync == NULL || sync.destroy_sync == NULL ||
+		sync.wait_sync == NULL || sync.dup_native_fence_fd == NULL) {
+		return false;
+	}
+	sync.enabled = true;
+	return true;
+#else
+	LOG("sync: built without the dma-buf sync file ioctls\n");
+	return false;
+#endif
+}
+
+static void
+sync_surface_destroy(struct sc_sync_surface *sync_surface)
+{
+	wlr_addon_finish(&sync_surface->addon);
+	if (sync_surface->acquire_fd >= 0) {
+		close(sync_surface->acquire_fd);
+	}
+	free(sync_surface);
+}
+
+static void
+sync_surface_handle_addon_destroy(struct wlr_addon *addon)
+{
+	struct sc_sync_surface *sync_surface =
+		wl_container_of(addon, sync_surface, addon);
+	sync_surface_destroy(sync_surface);
+}
+
+static const struct wlr_addon_interface sync_surface_addon_impl = {
+	.name = "sc_sync_surface",
+	.destroy = sync_surface_handle_addon_destroy,
+};
+
+static struct sc_sync_surface *
+sync_surface_find(struct wlr_surface *surface)
+{
+	struct wlr_addon *addon =
+		wlr_addon_find(&surface->addons, &sync, &sync_surface_addon_impl);
+	if (addon == NULL) {
+		return NULL;
+	}
+	struct sc_sync_surface *sync_surface;
+	return wl_container_of(addon, sync_surface, addon);
+}
+
+static bool
+surface_get_dmabuf(struct wlr_surface *surface,
+				   struct wlr_dmabuf_attributes *attribs)
+{
+	// shm buffers are copied into a texture on commit, nothing to wait for
+	if (surface->buffer == NULL || surface->buffer->source == NULL) {
+		return false;
+	}
+	return wlr_buffer_get_dmabuf(surface->buffer->source, attribs);
+}
+
+#ifdef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+/* the planes usually share a single buffer object, merged otherwise */
+static int
+dmabuf_export_acquire_fd(struct wlr_dmabuf_attributes *attribs)
+{
+	int fence_fd = -1;
+	for (int i = 0; i < attribs->n_planes; i++) {
+		if (i > 0 && attribs->fd[i] == attribs->fd[i - 1]) {
+			continue;
+		}
+		struct dma_buf_export_sync_file export = {
+			.flags = DMA_BUF_SYNC_READ,
+			.fd = -1,
+		};
+		if (sync_ioctl(attribs->fd[i], DMA_BUF_IOCTL_EXPORT_SYNC_FILE,
+					   &export) < 0) {
+			sync_disable("DMA_BUF_IOCTL_EXPORT_SYNC_FILE");
+			break;
+		}
+		if (fence_fd < 0) {
+			fence_fd = export.fd;
+			continue;
+		}
+		struct sync_merge_data merge = {
+			.name = "sc acquire",
+			.fd2 = export.fd,
+		};
+		int ret = sync_ioctl(fence_fd, SYNC_IOC_MERGE, &merge);
+		close(export.fd);
+		if (ret < 0) {
+			break;
+		}
+		close(fence_fd);
+		fence_fd = merge.fence;
+	}
+	return fence_fd;
+}
+#endif
+
+void
+sc_sync_surface_commit(struct wlr_surface *surface)
+{
+	struct sc_sync_surface *sync_surface = sync_surface_find(surface);
+	struct wlr_dmabuf_attributes attribs;
+	if (!sync.enabled || !surface_get_dmabuf(surface, &attribs)) {
+		if (sync_surface != NULL) {
+			sync_surface_destroy(sync_surface);
+		}
+		return;
+	}
+
+	if (sync_surface == NULL) {
+		sync_surface = calloc(1, sizeof(struct sc_sync_surface));
+		if (sync_surface == NULL) {
+			return;
+		}
+		sync_surface->acquire_fd = -1;
+		wlr_addon_init(&sync_surface->addon, &surface->addons, &sync,
+					   &sync_surface_addon_impl);
+	}
+	if (sync_surface->acquire_fd >= 0) {
+		// the previous buffer was never drawn
+		close(sync_surface->acquire_fd);
+		sync_surface->acquire_fd = -1;
+	}
+#ifdef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+	sync_surface->acquire_fd = dmabuf_export_acquire_fd(&attribs);
+#endif
+}
+
+void
+sc_sync_surface_acquire(struct wlr_surface *surface)
+{
+	struct sc_sync_surface *sync_surface = sync_surface_find(surface);
+	if (!sync.enabled || sync_surface == NULL ||
+		sync_surface->acquire_fd < 0) {
+		return;
+	}
+	int fd = sync_surface->acquire_fd;
+	sync_surface->acquire_fd = -1;
+
+	EGLint attribs[] = {
+		EGL_SYNC_NATIVE_FENCE_FD_ANDROID,
+		fd,
+		EGL_NONE,
+	};
+	EGLSyncKHR fence =
+		sync.create_sync(sync.display, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+	if (fence == EGL_NO_SYNC_KHR) {
+		// EGL only owns the fd on success
+		close(fd);
+		return;
+	}
+	// a wait on the GPU queue, the CPU goes on
+	sync.wait_sync(sync.display, fence, 0);
+	sync.destroy_sync(sync.display, fence);
+}
+
+int
+sc_sync_frame_fence()
+{
+	if (!sync.enabled) {
+		return -1;
+	}
+	EGLSyncKHR fence =
+		sync.create_sync(sync.display, EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+	if (fence == EGL_NO_SYNC_KHR) {
+		return -1;
+	}
+	// the fd only exists once the fence is flushed
+	glFlush();
+	int fd = sync.dup_native_fence_fd(sync.display, fence);
+	sync.destroy_sync(sync.display, fence);
+	return fd == EGL_NO_NATIVE_FENCE_FD_ANDROID ? -1 : fd;
+}
+
+void
+sc_sync_surface_release(struct wlr_surface *surface, int fence_fd)
+{
+#ifdef DMA_BUF_IOCTL_IMPORT_SYNC_FILE
+	struct wlr_dmabuf_attributes attribs;
+	if (!sync.enabled || fence_fd < 0 ||
+		!surface_get_dmabuf(surface, &attribs)) {
+		return;
+	}
+	for (int i = 0; i < attribs.n_planes; i++) {
+		if (i > 0 && attribs.fd[i] == attribs.fd[i - 1]) {
+			continue;
+		}
+		// the next writes of the client wait for the frame to be done
+		struct dma_buf_import_sync_file import = {
+			.flags = DMA_BUF_SYNC_READ,
+			.fd = fence_fd,
+		};
+		if (sync_ioctl(attribs.fd[i], DMA_BUF_IOCTL_IMPORT_SYNC_FILE,
+					   &import) < 0) {
+			sync_disable("DMA_BUF_IOCTL_IMPORT_SYNC_FILE");
+			return;
+		}
+	}
+#endif
+}
@@ -75,7 +75,6 @@ static void layer_surface_role_commit(struct wlr_surface *wlr_surface) {
 	if (surface == NULL) {
 		return;
 	}
-  DLOG("layer_surface_role_commit\n");
 	surface->current = surface->pending;
 	surface->pending.committed = 0;
 
@@ -16,6 +16,7 @@ int
 main(int argc, char **argv, char **environ)
 {
 	//	wlr_log_init(WLR_DEBUG, NULL);
+	sc_log_init(sc_log_level, true);
 
 	char *startup_cmd = NULL;
 	char *config_file = "./config.ini";
@@ -41,12 +42,24 @@ main(int argc, char **argv, char **environ)
     if (sc_load_config(config_file)) {
         ELOG("can't load %s\n", config_file);
     }
+	enum sc_log_level log_level;
+	if (configuration.log_level != NULL) {
+		if (sc_log_level_from_name(configuration.log_level, &log_level)) {
+			sc_log_level = log_level;
+		} else {
+			ELOG("unknown log level '%s'\n", configuration.log_level);
+		}
+	}
 	LOG("config loaded from '%s'\n", config_file);
 	LOG("display:%dx%d:%d\n", configuration.display_width,
 		configuration.display_height, configuration.display_refresh);
-	LOG("shaders:%s\n", configuration.shaders_path);
+	LOG("shaders:%s\n", configuration.shaders_path ? configuration.shaders_path
+												   : "embedded");
 
-	sc_compositor_create();
+	if (sc_compositor_create() == NULL) {
+		ELOG("can't create the compositor\n");
+		return 1;
+	}
 	sc_compositor_start_server();
 
 	setenv("WAYLAND_DISPLAY", sc_compositor_get_socket(), true);
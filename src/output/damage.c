@@ -70,3 +70,14 @@ sc_output_add_damage_from_view(struct sc_output *output, struct sc_view *view,
 
 	sc_view_for_each_surface(view, add_damage_surface_iterator, &data);
 }
+
+void
+sc_output_add_damage_box(struct sc_output *output, const struct wlr_box *box)
+{
+	struct wlr_box output_box;
+	if (!wlr_box_intersection(&output_box, output->output_box, box)) {
+		return;
+	}
+	sc_box_from_layout_to_output(output, &output_box);
+	wlr_output_damage_add_box(output->damage, &output_box);
+}
@@ -0,0 +1,47 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sc_frame_timing.h"
+
+#define NSEC_PER_MSEC 1000000LL
+// longer than that between two frames, the content was paused
+#define SC_FRAME_TIMING_IDLE (500 * NSEC_PER_MSEC)
+
+int
+sc_frame_timing_delay_ms(const struct sc_frame_timing *timing, int64_t now)
+{
+	if (timing->adaptive || timing->render_time == 0) {
+		return 0;
+	}
+	int64_t until_refresh = timing->last_present + timing->refresh - now;
+	// floored, better render a bit early than miss the refresh
+	int msec_until_refresh =
+		until_refresh > 0 ? (int) (until_refresh / NSEC_PER_MSEC) : 0;
+	return msec_until_refresh - timing->render_time;
+}
+
+int64_t
+sc_frame_timing_average(int64_t average, int64_t sample)
+{
+	if (sample <= 0 || sample > SC_FRAME_TIMING_IDLE) {
+		// starts over from the next one
+		return 0;
+	}
+	if (average == 0) {
+		return sample;
+	}
+	return average + (sample - average) / 8;
+}
+
+int64_t
+sc_frame_timing_lfc_interval(int64_t content, int64_t min_frame,
+							 int64_t max_frame)
+{
+	if (content <= 0 || max_frame <= 0 || content <= max_frame) {
+		return 0;
+	}
+	int64_t repeats = (content + max_frame - 1) / max_frame;
+	int64_t interval = content / repeats;
+	if (interval < min_frame) {
+		return 0;
+	}
+	return interval;
+}
@@ -0,0 +1,137 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stddef.h>
+
+#include "sc_layer_arrange.h"
+
+static void
+layer_apply_exclusive(const struct sc_layer_arrange_state *state,
+					  struct wlr_box *usable)
+{
+	if (state->exclusive_zone <= 0) {
+		return;
+	}
+	// a zone is reserved on the edge the surface is anchored to
+	struct {
+		uint32_t singular_anchor;
+		uint32_t anchor_triplet;
+		int *positive_axis;
+		int *negative_axis;
+		int margin;
+	} edges[] = {
+		{
+			.singular_anchor = SC_LAYER_ANCHOR_TOP,
+			.anchor_triplet = SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_RIGHT |
+							  SC_LAYER_ANCHOR_TOP,
+			.positive_axis = &usable->y,
+			.negative_axis = &usable->height,
+			.margin = state->margin_top,
+		},
+		{
+			.singular_anchor = SC_LAYER_ANCHOR_BOTTOM,
+			.anchor_triplet = SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_RIGHT |
+							  SC_LAYER_ANCHOR_BOTTOM,
+			.positive_axis = NULL,
+			.negative_axis = &usable->height,
+			.margin = state->margin_bottom,
+		},
+		{
+			.singular_anchor = SC_LAYER_ANCHOR_LEFT,
+			.anchor_triplet = SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_TOP |
+							  SC_LAYER_ANCHOR_BOTTOM,
+			.positive_axis = &usable->x,
+			.negative_axis = &usable->width,
+			.margin = state->margin_left,
+		},
+		{
+			.singular_anchor = SC_LAYER_ANCHOR_RIGHT,
+			.anchor_triplet = SC_LAYER_ANCHOR_RIGHT | SC_LAYER_ANCHOR_TOP |
+							  SC_LAYER_ANCHOR_BOTTOM,
+			.positive_axis = NULL,
+			.negative_axis = &usable->width,
+			.margin = state->margin_right,
+		},
+	};
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		if ((state->anchor == edges[i].singular_anchor ||
+			 state->anchor == edges[i].anchor_triplet) &&
+			state->exclusive_zone + edges[i].margin > 0) {
+			if (edges[i].positive_axis != NULL) {
+				*edges[i].positive_axis +=
+					state->exclusive_zone + edges[i].margin;
+			}
+			if (edges[i].negative_axis != NULL) {
+				*edges[i].negative_axis -=
+					state->exclusive_zone + edges[i].margin;
+			}
+			break;
+		}
+	}
+}
+
+bool
+sc_layer_arrange_box(const struct sc_layer_arrange_state *state,
+					 const struct wlr_box *full, struct wlr_box *usable,
+					 struct wlr_box *box)
+{
+	// -1 ignores the zones of the others
+	const struct wlr_box *bounds =
+		state->exclusive_zone == -1 ? full : usable;
+	box->width = state->desired_width;
+	box->height = state->desired_height;
+
+	const uint32_t both_horiz = SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_RIGHT;
+	if (box->width == 0) {
+		box->x = bounds->x;
+	} else if ((state->anchor & both_horiz) == both_horiz) {
+		box->x = bounds->x + (bounds->width / 2 - box->width / 2);
+	} else if (state->anchor & SC_LAYER_ANCHOR_LEFT) {
+		box->x = bounds->x;
+	} else if (state->anchor & SC_LAYER_ANCHOR_RIGHT) {
+		box->x = bounds->x + (bounds->width - box->width);
+	} else {
+		box->x = bounds->x + (bounds->width / 2 - box->width / 2);
+	}
+
+	const uint32_t both_vert = SC_LAYER_ANCHOR_TOP | SC_LAYER_ANCHOR_BOTTOM;
+	if (box->height == 0) {
+		box->y = bounds->y;
+	} else if ((state->anchor & both_vert) == both_vert) {
+		box->y = bounds->y + (bounds->height / 2 - box->height / 2);
+	} else if (state->anchor & SC_LAYER_ANCHOR_TOP) {
+		box->y = bounds->y;
+	} else if (state->anchor & SC_LAYER_ANCHOR_BOTTOM) {
+		box->y = bounds->y + (bounds->height - box->height);
+	} else {
+		box->y = bounds->y + (bounds->height / 2 - box->height / 2);
+	}
+
+	// a 0 size stretches between the anchored edges, minus the margins
+	if (box->width == 0) {
+		box->x += state->margin_left;
+		box->width =
+			bounds->width - (state->margin_left + state->margin_right);
+	} else if ((state->anchor & both_horiz) == both_horiz) {
+		// centered, the margins don't apply
+	} else if (state->anchor & SC_LAYER_ANCHOR_LEFT) {
+		box->x += state->margin_left;
+	} else if (state->anchor & SC_LAYER_ANCHOR_RIGHT) {
+		box->x -= state->margin_right;
+	}
+	if (box->height == 0) {
+		box->y += state->margin_top;
+		box->height =
+			bounds->height - (state->margin_top + state->margin_bottom);
+	} else if ((state->anchor & both_vert) == both_vert) {
+		// centered
+	} else if (state->anchor & SC_LAYER_ANCHOR_TOP) {
+		box->y += state->margin_top;
+	} else if (state->anchor & SC_LAYER_ANCHOR_BOTTOM) {
+		box->y -= state->margin_bottom;
+	}
+	if (box->width <= 0 || box->height <= 0) {
+		return false;
+	}
+
+	layer_apply_exclusive(state, usable);
+	return true;
+}
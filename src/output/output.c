@@ -5,12 +5,14 @@
 #include <wlr/types/wlr_output_damage.h>
 
 #include "log.h"
+#include "sc_compositor_cursor.h"
 #include "sc_compositor_rendering.h"
 #include "sc_config.h"
 #include "sc_output.h"
 #include "sc_output_repaintdelay.h"
 #include "sc_view.h"
 #include "sc_skia.h"
+#include "sc_wlr_layer_view.h"
 
 extern struct sc_configuration configuration;
 
@@ -36,6 +38,7 @@ sc_output_create(struct wlr_output *wlr_output,
 	output->layout = compositor->output_layout;
 	output->damage = wlr_output_damage_create(wlr_output);
 	output->max_render_time = configuration.max_render_time;
+	sc_render_list_init(&output->render_list);
 	wlr_output_init_render(output->wlr_output, compositor->wlr_allocator,
 						   compositor->wlr_renderer);
 	wlr_output_set_custom_mode(output->wlr_output, configuration.display_width,
@@ -56,12 +59,22 @@ sc_output_create(struct wlr_output *wlr_output,
 	}
 	output->enabled = true;
 
+	if (configuration.adaptive_sync) {
+		// turned on by the fullscreen views only, see render_list_update
+		wlr_output_enable_adaptive_sync(output->wlr_output, true);
+		output->adaptive_sync_capable = wlr_output_test(output->wlr_output);
+		wlr_output_rollback(output->wlr_output);
+		DLOG("output %s: adaptive sync %s\n", output->wlr_output->name,
+			 output->adaptive_sync_capable ? "supported" : "not supported");
+	}
+
 	output->on_mode.notify = output_on_mode;
 	wl_signal_add(&output->wlr_output->events.mode, &output->on_mode);
 
 	// TODO add listener for layout changes
 	output->output_box =
 		wlr_output_layout_get_box(output->layout, output->wlr_output);
+	output->usable_area = *output->output_box;
 
 	// TODO calculate projection matrix
 	output->projection_matrix = calloc(1, sizeof(float) * 9);
@@ -69,6 +82,8 @@ sc_output_create(struct wlr_output *wlr_output,
 
 	output->repaint_timer = wl_event_loop_add_timer(
 		compositor->wl_event_loop, output_repaint_timer_handler, output);
+	output->lfc_timer = wl_event_loop_add_timer(
+		compositor->wl_event_loop, sc_output_lfc_timer_handler, output);
 
 	/* sets up a listener for the frame notify event. */
 	output->on_frame.notify = output_on_frame;
@@ -79,15 +94,52 @@ sc_output_create(struct wlr_output *wlr_output,
 	wlr_output_damage_whole(output->wlr_output);
 
 	int width, height;
-  	wlr_output_transformed_resolution(output->wlr_output, &width, &height);
-	
-	
-	output->fbo = fbo_create(width, height);
-	output->skia = skia_context_create_for_view(output->fbo);
+	wlr_output_transformed_resolution(output->wlr_output, &width, &height);
+
+	// without an fbo the output is rendered directly by the gles2 path
+	output->fbo = sc_fbo_pool_acquire(width, height, GL_RGBA);
+	if (output->fbo != NULL) {
+		output->skia = skia_context_create_for_view(output->fbo);
+		if (output->skia == NULL) {
+			sc_fbo_pool_release(output->fbo);
+			output->fbo = NULL;
+		}
+	}
 
 	return output;
 }
 
+static void
+output_update_fbo(struct sc_output *output)
+{
+	int width, height;
+	wlr_output_transformed_resolution(output->wlr_output, &width, &height);
+
+	if (output->fbo != NULL && output->fbo->width == width &&
+		output->fbo->height == height) {
+		return;
+	}
+	sc_fbo_pool_release(output->fbo);
+	output->fbo = sc_fbo_pool_acquire(width, height, GL_RGBA);
+	if (output->fbo == NULL) {
+		ELOG("output: no fbo for %dx%d, rendering without skia\n", width,
+			 height);
+		return;
+	}
+	bool wrapped;
+	if (output->skia == NULL) {
+		output->skia = skia_context_create_for_view(output->fbo);
+		wrapped = output->skia != NULL;
+	} else {
+		wrapped = skia_context_set_fbo(output->skia, output->fbo);
+	}
+	if (!wrapped) {
+		// the gles2 path takes over
+		sc_fbo_pool_release(output->fbo);
+		output->fbo = NULL;
+	}
+}
+
 static int
 output_repaint_timer_handler(void *data)
 {
@@ -102,6 +154,9 @@ output_repaint_timer_handler(void *data)
 		goto repaint_end;
 	}
 
+	// pending pointer motion lands its damage in this frame
+	sc_compositor_cursor_flush(output->compositor);
+
 	output->wlr_output->frame_pending = false;
 
 	if (!wlr_output_damage_attach_render(output->damage, &needs_frame,
@@ -120,6 +175,7 @@ output_repaint_timer_handler(void *data)
 
 repaint_end:
 	pixman_region32_fini(&damage);
+	sc_fbo_pool_frame_done();
 
 	// Send frame done to all visible surfaces in the output
 	struct timespec when;
@@ -132,7 +188,7 @@ repaint_end:
 static void
 output_on_present(struct wl_listener *listener, void *data)
 {
-	struct sc_output *output = wl_container_of(listener, output, on_frame);
+	struct sc_output *output = wl_container_of(listener, output, on_present);
 	struct wlr_output_event_present *output_event = data;
 
 	if (!output->enabled || !output_event->presented) {
@@ -147,6 +203,8 @@ output_on_frame(struct wl_listener *listener, void *data)
 	struct sc_output *output = wl_container_of(listener, output, on_frame);
 
 	if (!output->enabled || !output->wlr_output->enabled) {
+		// the motion waiting for this frame would wait forever
+		sc_compositor_cursor_flush(output->compositor);
 		return;
 	}
 
@@ -169,6 +227,12 @@ output_on_mode(struct wl_listener *listener, void *data)
 {
 	struct sc_output *output = wl_container_of(listener, output, on_mode);
 	output_update_matrix(output);
+	output_update_fbo(output);
+	output->render_list.valid = false;
+	if (output->skia != NULL) {
+		skia_invalidate_background(output->skia);
+	}
+	sc_wlr_layer_views_arrange(output->compositor, output);
 }
 
 static void
@@ -182,7 +246,21 @@ send_frame_done_iterator(struct wlr_surface *surface, int sx, int sy,
 void
 sc_output_send_frame_done(struct sc_output *output, struct timespec *when)
 {
-	sc_output_for_each_view_surface(output, send_frame_done_iterator, when);
+	struct sc_render_list *list = &output->render_list;
+	if (!list->valid ||
+		list->scene_serial != output->compositor->scene_serial) {
+		sc_output_for_each_view_surface(output, send_frame_done_iterator,
+										when);
+		return;
+	}
+	// the views hidden under opaque ones wait until they show again
+	for (size_t i = 0; i < list->len; i++) {
+		struct sc_render_item *item = &list->items[i];
+		if (i == item->tree && item->tree_visible) {
+			sc_view_for_each_surface(item->view, send_frame_done_iterator,
+									 when);
+		}
+	}
 }
 static void
 output_update_matrix(struct sc_output *output)
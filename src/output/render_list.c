@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pixman.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sc_render_list.h"
+
+void
+sc_render_list_init(struct sc_render_list *list)
+{
+	memset(list, 0, sizeof(*list));
+}
+
+void
+sc_render_list_finish(struct sc_render_list *list)
+{
+	free(list->items);
+	memset(list, 0, sizeof(*list));
+}
+
+void
+sc_render_list_reset(struct sc_render_list *list)
+{
+	list->len = 0;
+	list->background_len = 0;
+}
+
+struct sc_render_item *
+sc_render_list_add(struct sc_render_list *list)
+{
+	if (list->len == list->cap) {
+		size_t cap = list->cap == 0 ? 32 : list->cap * 2;
+		struct sc_render_item *items =
+			realloc(list->items, cap * sizeof(struct sc_render_item));
+		if (items == NULL) {
+			return NULL;
+		}
+		list->items = items;
+		list->cap = cap;
+	}
+	struct sc_render_item *item = &list->items[list->len++];
+	memset(item, 0, sizeof(*item));
+	return item;
+}
+
+static pixman_box32_t
+box_to_pixman(const struct wlr_box *box)
+{
+	return (pixman_box32_t){
+		.x1 = box->x,
+		.y1 = box->y,
+		.x2 = box->x + box->width,
+		.y2 = box->y + box->height,
+	};
+}
+
+void
+sc_render_list_cull(struct sc_render_list *list, const struct wlr_box *bounds)
+{
+	pixman_region32_t covered;
+	pixman_region32_init(&covered);
+	pixman_box32_t bounds_box = box_to_pixman(bounds);
+
+	for (size_t i = 0; i < list->len; i++) {
+		list->items[list->items[i].tree].tree_visible = false;
+	}
+	// from the top, each item sees what's been covered above it
+	for (size_t i = list->len; i-- > 0;) {
+		struct sc_render_item *item = &list->items[i];
+		pixman_box32_t box = box_to_pixman(&item->box);
+		item->occluded = false;
+		if (i >= list->background_len) {
+			item->occluded =
+				item->box.width <= 0 || item->box.height <= 0 ||
+				box.x2 <= bounds_box.x1 || box.x1 >= bounds_box.x2 ||
+				box.y2 <= bounds_box.y1 || box.y1 >= bounds_box.y2 ||
+				pixman_region32_contains_rectangle(&covered, &box) ==
+					PIXMAN_REGION_IN;
+		}
+		if (!item->occluded) {
+			list->items[item->tree].tree_visible = true;
+		}
+		if (item->opaque_box.width > 0 && item->opaque_box.height > 0) {
+			pixman_region32_union_rect(
+				&covered, &covered, item->opaque_box.x, item->opaque_box.y,
+				item->opaque_box.width, item->opaque_box.height);
+		}
+	}
+	pixman_region32_fini(&covered);
+}
+
+struct sc_view *
+sc_render_list_fullscreen_view(struct sc_render_list *list,
+							   const struct wlr_box *bounds)
+{
+	struct sc_render_item *root = NULL;
+	for (size_t i = list->background_len; i < list->len; i++) {
+		struct sc_render_item *item = &list->items[i];
+		if (item->occluded) {
+			continue;
+		}
+		if (root != NULL && item->tree != root->tree) {
+			return NULL;
+		}
+		root = &list->items[item->tree];
+	}
+	if (root == NULL || root->box.x > bounds->x || root->box.y > bounds->y ||
+		root->box.x + root->box.width < bounds->x + bounds->width ||
+		root->box.y + root->box.height < bounds->y + bounds->height) {
+		return NULL;
+	}
+	return root->view;
+}
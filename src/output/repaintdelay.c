@@ -1,8 +1,96 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "log.h"
+#include "sc_config.h"
+#include "sc_frame_timing.h"
 #include "sc_output.h"
 #include "sc_output_repaintdelay.h"
+#include "sc_toplevel_view.h"
+
+#define NSEC_IN_SECONDS 1000000000LL
+
+extern struct sc_configuration configuration;
+
+static int64_t
+timespec_to_nsec(const struct timespec *ts)
+{
+	return (int64_t) ts->tv_sec * NSEC_IN_SECONDS + ts->tv_nsec;
+}
+
+static int64_t
+output_now(struct sc_output *output, struct timespec *now)
+{
+	clockid_t presentation_clock =
+		wlr_backend_get_presentation_clock(output->compositor->wlr_backend);
+	clock_gettime(presentation_clock, now);
+	return timespec_to_nsec(now);
+}
+
+static bool
+output_is_adaptive(struct sc_output *output)
+{
+	return output->content_view != NULL &&
+		   output->wlr_output->adaptive_sync_status ==
+			   WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
+}
+
+/* repeats the last frame if the next one of the content is late */
+static void
+output_schedule_lfc(struct sc_output *output)
+{
+	if (!output_is_adaptive(output) || configuration.vrr_min_refresh <= 0) {
+		return;
+	}
+	int64_t max_frame = (NSEC_IN_SECONDS + configuration.vrr_min_refresh - 1) /
+						configuration.vrr_min_refresh;
+	int64_t interval = sc_frame_timing_lfc_interval(
+		output->content_interval_nsec, output->refresh_nsec, max_frame);
+	if (interval == 0) {
+		return;
+	}
+	int64_t repeat = timespec_to_nsec(&output->last_presentation) + interval;
+	int64_t content_due = timespec_to_nsec(&output->last_content_commit) +
+						  output->content_interval_nsec;
+	if (repeat + interval / 2 > content_due) {
+		// the content frame comes first
+		return;
+	}
+	struct timespec now;
+	int64_t delay = repeat - output_now(output, &now);
+	int msec = delay > 0 ? (int) (delay / 1000000) : 0;
+	wl_event_source_timer_update(output->lfc_timer, msec > 0 ? msec : 1);
+}
+
+/* how long the content view waits, from its commit to the screen */
+static void
+output_record_latency(struct sc_output *output,
+					  struct wlr_output_event_present *output_event)
+{
+	if (!output->frame_content ||
+		output_event->commit_seq != output->frame_commit_seq) {
+		return;
+	}
+	output->frame_content = false;
+	int mode = output->frame_low_latency ? 1 : 0;
+	output->latency_nsec[mode] +=
+		timespec_to_nsec(output_event->when) -
+		timespec_to_nsec(&output->frame_content_commit);
+	output->latency_frames[mode]++;
+
+	if (output->latency_frames[mode] % 600 != 0) {
+		return;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (output->latency_frames[i] == 0) {
+			continue;
+		}
+		LOG("output %s: %s commit to present %.2fms over %llu frames\n",
+			 output->wlr_output->name, i == 1 ? "low latency" : "vsynced",
+			 output->latency_nsec[i] / (double) output->latency_frames[i] /
+				 1e6,
+			 (unsigned long long) output->latency_frames[i]);
+	}
+}
 
 void
 sc_output_update_presentation(struct sc_output *output,
@@ -10,6 +98,8 @@ sc_output_update_presentation(struct sc_output *output,
 {
 	output->last_presentation = *output_event->when;
 	output->refresh_nsec = output_event->refresh;
+	output_record_latency(output, output_event);
+	output_schedule_lfc(output);
 }
 
 int
@@ -17,43 +107,89 @@ sc_output_get_ms_until_refresh(struct sc_output *output)
 {
 	// Compute predicted milliseconds until the next refresh. It's used for
 	// delaying both output rendering and surface frame callbacks.
-	int msec_until_refresh = 0;
-
-	if (output->max_render_time != 0) {
-		struct timespec now;
-		clockid_t presentation_clock =
-			wlr_backend_get_presentation_clock(output->compositor->wlr_backend);
-		clock_gettime(presentation_clock, &now);
-
-		const long NSEC_IN_SECONDS = 1000000000;
-		struct timespec predicted_refresh = output->last_presentation;
-		predicted_refresh.tv_nsec += output->refresh_nsec % NSEC_IN_SECONDS;
-		predicted_refresh.tv_sec += output->refresh_nsec / NSEC_IN_SECONDS;
-		if (predicted_refresh.tv_nsec >= NSEC_IN_SECONDS) {
-			predicted_refresh.tv_sec += 1;
-			predicted_refresh.tv_nsec -= NSEC_IN_SECONDS;
-		}
+	if (output->low_latency) {
+		return 0;
+	}
+	struct sc_frame_timing timing = {
+		.last_present = timespec_to_nsec(&output->last_presentation),
+		.refresh = output->refresh_nsec,
+		.render_time = output->max_render_time,
+		.adaptive = output_is_adaptive(output),
+	};
+	struct timespec now;
+	return sc_frame_timing_delay_ms(&timing, output_now(output, &now));
+}
 
-		// If the predicted refresh time is before the current time then
-		// there's no point in delaying.
-		//
-		// We only check tv_sec because if the predicted refresh time is less
-		// than a second before the current time, then msec_until_refresh will
-		// end up slightly below zero, which will effectively disable the delay
-		// without potential disastrous negative overflows that could occur if
-		// tv_sec was not checked.
-		if (predicted_refresh.tv_sec >= now.tv_sec) {
-			long nsec_until_refresh =
-				(predicted_refresh.tv_sec - now.tv_sec) * NSEC_IN_SECONDS +
-				(predicted_refresh.tv_nsec - now.tv_nsec);
-
-			// We want msec_until_refresh to be conservative, that is, floored.
-			// If we have 7.9 msec until refresh, we better compute the delay
-			// as if we had only 7 msec, so that we don't accidentally delay
-			// more than necessary and miss a frame.
-			msec_until_refresh = nsec_until_refresh / 1000000;
-		}
+void
+sc_output_set_content_view(struct sc_output *output, struct sc_view *view)
+{
+	if (output->content_view == view) {
+		return;
+	}
+	output->content_view = view;
+	output->low_latency = view != NULL && view->type == SC_VIEW_TOPLEVEL &&
+						  ((struct sc_toplevel_view *) view)->low_latency;
+	output->content_pending = false;
+	output->frame_content = false;
+	output->content_interval_nsec = 0;
+	output->last_content_commit = (struct timespec){0};
+	wl_event_source_timer_update(output->lfc_timer, 0);
+	if (output->adaptive_sync_capable) {
+		// applied with the frame being rendered
+		DLOG("output: adaptive sync %s\n", view != NULL ? "on" : "off");
+		wlr_output_enable_adaptive_sync(output->wlr_output, view != NULL);
 	}
+}
 
-	return msec_until_refresh - output->max_render_time;
+static void
+send_frame_done_iterator(struct wlr_surface *surface, int sx, int sy,
+						 void *user_data)
+{
+	struct timespec *when = user_data;
+	wlr_surface_send_frame_done(surface, when);
+}
+
+void
+sc_output_content_commit(struct sc_output *output)
+{
+	struct timespec now;
+	int64_t now_nsec = output_now(output, &now);
+	if (output->last_content_commit.tv_sec != 0) {
+		output->content_interval_nsec = sc_frame_timing_average(
+			output->content_interval_nsec,
+			now_nsec - timespec_to_nsec(&output->last_content_commit));
+	}
+	output->last_content_commit = now;
+	output->content_pending = true;
+	// the new frame replaces the repeat
+	wl_event_source_timer_update(output->lfc_timer, 0);
+
+	if (output->low_latency) {
+		sc_view_for_each_surface(output->content_view, send_frame_done_iterator,
+								 &now);
+	}
+}
+
+void
+sc_output_frame_committed(struct sc_output *output)
+{
+	if (!output->content_pending) {
+		return;
+	}
+	// this frame shows the last commit of the content view
+	output->content_pending = false;
+	output->frame_content = true;
+	output->frame_low_latency = output->low_latency;
+	output->frame_commit_seq = output->wlr_output->commit_seq;
+	output->frame_content_commit = output->last_content_commit;
+}
+
+int
+sc_output_lfc_timer_handler(void *data)
+{
+	struct sc_output *output = data;
+	if (output->enabled) {
+		wlr_output_damage_add_whole(output->damage);
+	}
+	return 0;
 }
@@ -6,8 +6,24 @@
 #include "sc_output.h"
 #include "sc_toplevel_view.h"
 #include "sc_view.h"
+#include "sc_wlr_layer_view.h"
 #include "sc_workspace.h"
 
+static void
+for_each_layer_surface(struct sc_output *output, struct wl_list *layers,
+					   wlr_surface_iterator_func_t surface_iterator,
+					   void *data)
+{
+	struct sc_wlr_layer_view *layer_view;
+	wl_list_for_each (layer_view, layers, link) {
+		if (layer_view->super.output != output ||
+			!layer_view->super.mapped) {
+			continue;
+		}
+		sc_view_for_each_surface(&layer_view->super, surface_iterator, data);
+	}
+}
+
 /* this function iterates across all views intersecting the output */
 void
 sc_output_for_each_view_surface(struct sc_output *output,
@@ -18,8 +34,16 @@ sc_output_for_each_view_surface(struct sc_output *output,
 	struct sc_workspace *workspace = output->compositor->current_workspace;
 	wl_list_for_each (toplevel, &workspace->views_toplevel, link) {
 		if (sc_output_intersect_view(output, &toplevel->super) == false) {
-			return;
+			continue;
 		}
 		sc_view_for_each_surface(&toplevel->super, surface_iterator, data);
 	}
+	for_each_layer_surface(output, &workspace->layers_background,
+						   surface_iterator, data);
+	for_each_layer_surface(output, &workspace->layers_bottom,
+						   surface_iterator, data);
+	for_each_layer_surface(output, &workspace->layers_top, surface_iterator,
+						   data);
+	for_each_layer_surface(output, &workspace->layers_overlay,
+						   surface_iterator, data);
 }
@@ -0,0 +1,51 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+
+#include "sc_downscale.h"
+
+static int
+level_size(int final, int halvings, int src)
+{
+	long size = (long) final << halvings;
+	return size < src ? (int) size : src;
+}
+
+size_t
+sc_downscale_levels(int src_w, int src_h, int max_w, int max_h,
+					struct sc_downscale_level *levels, size_t max_levels)
+{
+	if (src_w <= 0 || src_h <= 0 || max_w <= 0 || max_h <= 0 ||
+		max_levels == 0) {
+		return 0;
+	}
+
+	double scale = 1.0;
+	if ((double) max_w / src_w < scale) {
+		scale = (double) max_w / src_w;
+	}
+	if ((double) max_h / src_h < scale) {
+		scale = (double) max_h / src_h;
+	}
+	int width = (int) lround(src_w * scale);
+	int height = (int) lround(src_h * scale);
+	width = width < 1 ? 1 : width;
+	height = height < 1 ? 1 : height;
+
+	// the most halvings that don't start above the source size
+	size_t halvings = 0;
+	while (halvings + 1 < max_levels && scale * 2.0 <= 1.0) {
+		scale *= 2.0;
+		halvings++;
+	}
+	// a bilinear draw at half the size is already a box filter
+	if (halvings > 0 && level_size(width, halvings, src_w) == src_w &&
+		level_size(height, halvings, src_h) == src_h) {
+		halvings--;
+	}
+
+	for (size_t i = 0; i <= halvings; i++) {
+		levels[i].width = level_size(width, halvings - i, src_w);
+		levels[i].height = level_size(height, halvings - i, src_h);
+	}
+	return halvings + 1;
+}
@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+
+#include "sc_keybinding.h"
+
+void
+sc_keybindings_init(struct sc_keybindings *bindings, uint32_t mask)
+{
+	for (int i = 0; i < SC_KEYBINDING_BUCKETS; i++) {
+		bindings->buckets[i] = NULL;
+	}
+	bindings->mask = mask;
+	bindings->any_unmodified = false;
+	bindings->used_modifiers = 0;
+}
+
+void
+sc_keybindings_finish(struct sc_keybindings *bindings)
+{
+	for (int i = 0; i < SC_KEYBINDING_BUCKETS; i++) {
+		struct sc_keybinding *binding = bindings->buckets[i];
+		while (binding != NULL) {
+			struct sc_keybinding *next = binding->next;
+			free(binding);
+			binding = next;
+		}
+		bindings->buckets[i] = NULL;
+	}
+}
+
+static unsigned int
+keybinding_hash(uint32_t modifiers, xkb_keysym_t sym)
+{
+	return (sym * 2654435761u ^ modifiers * 40503u) % SC_KEYBINDING_BUCKETS;
+}
+
+bool
+sc_keybindings_add(struct sc_keybindings *bindings, uint32_t modifiers,
+				   xkb_keysym_t sym, sc_keybinding_action_t action)
+{
+	modifiers &= bindings->mask;
+	struct sc_keybinding *binding =
+		sc_keybindings_find(bindings, modifiers, sym);
+	if (binding != NULL) {
+		binding->action = action;
+		return true;
+	}
+
+	binding = calloc(1, sizeof(struct sc_keybinding));
+	if (binding == NULL) {
+		return false;
+	}
+	binding->modifiers = modifiers;
+	binding->sym = sym;
+	binding->action = action;
+
+	unsigned int bucket = keybinding_hash(modifiers, sym);
+	binding->next = bindings->buckets[bucket];
+	bindings->buckets[bucket] = binding;
+
+	if (modifiers == 0) {
+		bindings->any_unmodified = true;
+	}
+	bindings->used_modifiers |= modifiers;
+	return true;
+}
+
+bool
+sc_keybindings_may_match(struct sc_keybindings *bindings, uint32_t modifiers)
+{
+	modifiers &= bindings->mask;
+	if (modifiers == 0) {
+		return bindings->any_unmodified;
+	}
+	return (modifiers & bindings->used_modifiers) == modifiers;
+}
+
+struct sc_keybinding *
+sc_keybindings_find(struct sc_keybindings *bindings, uint32_t modifiers,
+					xkb_keysym_t sym)
+{
+	modifiers &= bindings->mask;
+	struct sc_keybinding *binding =
+		bindings->buckets[keybinding_hash(modifiers, sym)];
+	for (; binding != NULL; binding = binding->next) {
+		if (binding->modifiers == modifiers && binding->sym == sym) {
+			return binding;
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,731 @@
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "log.h"
+
+#define SC_LOG_RING_SIZE (256 * 1024) // a power of two
+#define SC_LOG_RECORD_MAX 1024
+#define SC_LOG_FLUSH_INTERVAL_MS 20
+#define SC_LOG_PADDING UINT32_MAX
+
+#ifdef DEBUG
+enum sc_log_level sc_log_level = SC_LOG_DEBUG;
+#else
+enum sc_log_level sc_log_level = SC_LOG_INFO;
+#endif
+
+/*
+ * Followed by the arguments, in the order of the format: integers widened to
+ * 64 bits, doubles, pointers, and strings copied as a length and the bytes.
+ * The first two fields are all a padding record has.
+ */
+struct log_record {
+	uint32_t size; // the arguments included, a multiple of 8
+	uint32_t level;
+	struct timespec time;
+	const char *fmt;
+};
+
+enum log_length {
+	LOG_LENGTH_NONE,
+	LOG_LENGTH_HH,
+	LOG_LENGTH_H,
+	LOG_LENGTH_L,
+	LOG_LENGTH_LL,
+	LOG_LENGTH_J,
+	LOG_LENGTH_Z,
+	LOG_LENGTH_T,
+	LOG_LENGTH_BIG_L,
+};
+
+struct log_spec {
+	const char *start; // the '%'
+	const char *length_start;
+	const char *end; // past the conversion
+	bool star_width;
+	bool star_precision;
+	enum log_length length;
+	char conversion;
+};
+
+static struct {
+	bool initialized;
+	pthread_t producer;
+	unsigned char *ring;
+	atomic_size_t head;
+	atomic_size_t tail;
+	atomic_uint dropped;
+
+	/* the flusher thread and sc_log_flush can both drain */
+	pthread_mutex_t drain_lock;
+
+	bool background;
+	pthread_t thread;
+	atomic_bool stop;
+	pthread_mutex_t wake_lock;
+	pthread_cond_t wake;
+
+	FILE *out;
+	FILE *err;
+	bool out_line_start;
+	bool err_line_start;
+	struct timespec start;
+} log_state = {
+	.drain_lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake_lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.out_line_start = true,
+	.err_line_start = true,
+};
+
+static FILE *
+log_stream(enum sc_log_level level)
+{
+	if (level == SC_LOG_ERROR) {
+		return log_state.err != NULL ? log_state.err : stderr;
+	}
+	return log_state.out != NULL ? log_state.out : stdout;
+}
+
+static const char *
+log_parse_spec(const char *p, struct log_spec *spec)
+{
+	spec->start = p++;
+	spec->star_width = false;
+	spec->star_precision = false;
+	spec->length = LOG_LENGTH_NONE;
+
+	while (*p != '\0' && strchr("-+ #0'", *p) != NULL) {
+		p++;
+	}
+	if (*p == '*') {
+		spec->star_width = true;
+		p++;
+	} else {
+		while (isdigit((unsigned char) *p)) {
+			p++;
+		}
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->star_precision = true;
+			p++;
+		} else {
+			while (isdigit((unsigned char) *p)) {
+				p++;
+			}
+		}
+	}
+
+	spec->length_start = p;
+	switch (*p) {
+	case 'h':
+		spec->length = p[1] == 'h' ? LOG_LENGTH_HH : LOG_LENGTH_H;
+		p += spec->length == LOG_LENGTH_HH ? 2 : 1;
+		break;
+	case 'l':
+		spec->length = p[1] == 'l' ? LOG_LENGTH_LL : LOG_LENGTH_L;
+		p += spec->length == LOG_LENGTH_LL ? 2 : 1;
+		break;
+	case 'j':
+		spec->length = LOG_LENGTH_J;
+		p++;
+		break;
+	case 'z':
+		spec->length = LOG_LENGTH_Z;
+		p++;
+		break;
+	case 't':
+		spec->length = LOG_LENGTH_T;
+		p++;
+		break;
+	case 'L':
+		spec->length = LOG_LENGTH_BIG_L;
+		p++;
+		break;
+	}
+
+	spec->conversion = *p;
+	if (*p != '\0') {
+		p++;
+	}
+	spec->end = p;
+	return p;
+}
+
+static bool
+log_put(unsigned char *buf, size_t cap, size_t *off, const void *src,
+		size_t size)
+{
+	if (*off + size > cap) {
+		return false;
+	}
+	memcpy(buf + *off, src, size);
+	*off += size;
+	return true;
+}
+
+static bool
+log_get(const unsigned char *buf, size_t len, size_t *off, void *dst,
+		size_t size)
+{
+	if (*off + size > len) {
+		return false;
+	}
+	memcpy(dst, buf + *off, size);
+	*off += size;
+	return true;
+}
+
+/* returns the size of the arguments, truncated when they don't fit */
+static size_t
+log_encode_args(unsigned char *buf, size_t cap, const char *fmt, va_list args)
+{
+	size_t off = 0;
+	const char *p = fmt;
+	while ((p = strchr(p, '%')) != NULL) {
+		if (p[1] == '%') {
+			p += 2;
+			continue;
+		}
+		struct log_spec spec;
+		p = log_parse_spec(p, &spec);
+
+		if (spec.star_width) {
+			int width = va_arg(args, int);
+			if (!log_put(buf, cap, &off, &width, sizeof(width))) {
+				return off;
+			}
+		}
+		if (spec.star_precision) {
+			int precision = va_arg(args, int);
+			if (!log_put(buf, cap, &off, &precision, sizeof(precision))) {
+				return off;
+			}
+		}
+
+		bool stored = true;
+		switch (spec.conversion) {
+		case 'd':
+		case 'i': {
+			long long v;
+			switch (spec.length) {
+			case LOG_LENGTH_HH:
+				v = (signed char) va_arg(args, int);
+				break;
+			case LOG_LENGTH_H:
+				v = (short) va_arg(args, int);
+				break;
+			case LOG_LENGTH_L:
+				v = va_arg(args, long);
+				break;
+			case LOG_LENGTH_LL:
+				v = va_arg(args, long long);
+				break;
+			case LOG_LENGTH_J:
+				v = va_arg(args, intmax_t);
+				break;
+			case LOG_LENGTH_Z:
+				v = (long long) va_arg(args, size_t);
+				break;
+			case LOG_LENGTH_T:
+				v = va_arg(args, ptrdiff_t);
+				break;
+			default:
+				v = va_arg(args, int);
+				break;
+			}
+			stored = log_put(buf, cap, &off, &v, sizeof(v));
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X': {
+			unsigned long long v;
+			switch (spec.length) {
+			case LOG_LENGTH_HH:
+				v = (unsigned char) va_arg(args, unsigned int);
+				break;
+			case LOG_LENGTH_H:
+				v = (unsigned short) va_arg(args, unsigned int);
+				break;
+			case LOG_LENGTH_L:
+				v = va_arg(args, unsigned long);
+				break;
+			case LOG_LENGTH_LL:
+				v = va_arg(args, unsigned long long);
+				break;
+			case LOG_LENGTH_J:
+				v = va_arg(args, uintmax_t);
+				break;
+			case LOG_LENGTH_Z:
+				v = va_arg(args, size_t);
+				break;
+			case LOG_LENGTH_T:
+				v = (unsigned long long) va_arg(args, ptrdiff_t);
+				break;
+			default:
+				v = va_arg(args, unsigned int);
+				break;
+			}
+			stored = log_put(buf, cap, &off, &v, sizeof(v));
+			break;
+		}
+		case 'c': {
+			int v = va_arg(args, int);
+			stored = log_put(buf, cap, &off, &v, sizeof(v));
+			break;
+		}
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (spec.length == LOG_LENGTH_BIG_L) {
+				long double v = va_arg(args, long double);
+				stored = log_put(buf, cap, &off, &v, sizeof(v));
+			} else {
+				double v = va_arg(args, double);
+				stored = log_put(buf, cap, &off, &v, sizeof(v));
+			}
+			break;
+		case 'p': {
+			void *v = va_arg(args, void *);
+			stored = log_put(buf, cap, &off, &v, sizeof(v));
+			break;
+		}
+		case 's': {
+			// the string may be gone by the time the record is flushed
+			const char *s = va_arg(args, const char *);
+			if (s == NULL) {
+				s = "(null)";
+			}
+			uint32_t len = strlen(s);
+			if (off + sizeof(len) + len + 1 > cap) {
+				if (off + sizeof(len) + 1 > cap) {
+					return off;
+				}
+				len = cap - off - sizeof(len) - 1;
+			}
+			log_put(buf, cap, &off, &len, sizeof(len));
+			log_put(buf, cap, &off, s, len);
+			buf[off++] = '\0';
+			break;
+		}
+		case 'n':
+			(void) va_arg(args, int *);
+			break;
+		default:
+			// can't tell what the argument is, the rest is printed as is
+			return off;
+		}
+		if (!stored) {
+			return off;
+		}
+	}
+	return off;
+}
+
+/*
+ * Prints one conversion with a copy of its spec, the length modifier replaced
+ * by the width the argument was stored with.
+ */
+#define LOG_PRINT_SPEC(stream, spec_buf, spec, width, precision, value)       \
+	do {                                                                      \
+		if ((spec)->star_width && (spec)->star_precision) {                   \
+			fprintf(stream, spec_buf, width, precision, value);               \
+		} else if ((spec)->star_width) {                                      \
+			fprintf(stream, spec_buf, width, value);                          \
+		} else if ((spec)->star_precision) {                                  \
+			fprintf(stream, spec_buf, precision, value);                      \
+		} else {                                                              \
+			fprintf(stream, spec_buf, value);                                 \
+		}                                                                     \
+	} while (0)
+
+static bool
+log_spec_copy(char *dst, size_t cap, const struct log_spec *spec,
+			  const char *length)
+{
+	size_t prefix = spec->length_start - spec->start;
+	size_t suffix = strlen(length);
+	if (prefix + suffix + 2 > cap) {
+		return false;
+	}
+	memcpy(dst, spec->start, prefix);
+	memcpy(dst + prefix, length, suffix);
+	dst[prefix + suffix] = spec->conversion;
+	dst[prefix + suffix + 1] = '\0';
+	return true;
+}
+
+static void
+log_print_record(FILE *stream, const char *fmt, const unsigned char *args,
+				 size_t len)
+{
+	size_t off = 0;
+	const char *p = fmt;
+	while (*p != '\0') {
+		const char *pct = strchr(p, '%');
+		if (pct == NULL) {
+			fputs(p, stream);
+			return;
+		}
+		fwrite(p, 1, pct - p, stream);
+		if (pct[1] == '%') {
+			fputc('%', stream);
+			p = pct + 2;
+			continue;
+		}
+
+		struct log_spec spec;
+		p = log_parse_spec(pct, &spec);
+
+		int width = 0, precision = 0;
+		if ((spec.star_width &&
+			 !log_get(args, len, &off, &width, sizeof(width))) ||
+			(spec.star_precision &&
+			 !log_get(args, len, &off, &precision, sizeof(precision)))) {
+			fputs("<truncated>", stream);
+			return;
+		}
+
+		char spec_buf[64];
+		bool ok = true;
+		switch (spec.conversion) {
+		case 'd':
+		case 'i': {
+			long long v;
+			ok = log_get(args, len, &off, &v, sizeof(v)) &&
+				 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "ll");
+			if (ok) {
+				LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision, v);
+			}
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X': {
+			unsigned long long v;
+			ok = log_get(args, len, &off, &v, sizeof(v)) &&
+				 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "ll");
+			if (ok) {
+				LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision, v);
+			}
+			break;
+		}
+		case 'c': {
+			int v;
+			ok = log_get(args, len, &off, &v, sizeof(v)) &&
+				 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "");
+			if (ok) {
+				LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision, v);
+			}
+			break;
+		}
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (spec.length == LOG_LENGTH_BIG_L) {
+				long double v;
+				ok = log_get(args, len, &off, &v, sizeof(v)) &&
+					 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "L");
+				if (ok) {
+					LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision,
+								   v);
+				}
+			} else {
+				double v;
+				ok = log_get(args, len, &off, &v, sizeof(v)) &&
+					 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "");
+				if (ok) {
+					LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision,
+								   v);
+				}
+			}
+			break;
+		case 'p': {
+			void *v;
+			ok = log_get(args, len, &off, &v, sizeof(v)) &&
+				 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "");
+			if (ok) {
+				LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision, v);
+			}
+			break;
+		}
+		case 's': {
+			uint32_t slen;
+			ok = log_get(args, len, &off, &slen, sizeof(slen)) &&
+				 off + slen + 1 <= len &&
+				 log_spec_copy(spec_buf, sizeof(spec_buf), &spec, "");
+			if (ok) {
+				const char *v = (const char *) args + off;
+				off += slen + 1;
+				LOG_PRINT_SPEC(stream, spec_buf, &spec, width, precision, v);
+			}
+			break;
+		}
+		case 'n':
+			break;
+		default:
+			fputs(spec.start, stream);
+			return;
+		}
+		if (!ok) {
+			fputs("<truncated>", stream);
+			return;
+		}
+	}
+}
+
+static void
+log_print(enum sc_log_level level, const struct timespec *time,
+		  const char *fmt, const unsigned char *args, size_t len)
+{
+	FILE *stream = log_stream(level);
+	bool *line_start = level == SC_LOG_ERROR ? &log_state.err_line_start
+											 : &log_state.out_line_start;
+	if (*line_start) {
+		long sec = time->tv_sec - log_state.start.tv_sec;
+		long nsec = time->tv_nsec - log_state.start.tv_nsec;
+		if (nsec < 0) {
+			sec--;
+			nsec += 1000000000;
+		}
+		fprintf(stream, "[%5ld.%06ld] ", sec, nsec / 1000);
+	}
+	log_print_record(stream, fmt, args, len);
+	size_t fmt_len = strlen(fmt);
+	*line_start = fmt_len > 0 && fmt[fmt_len - 1] == '\n';
+}
+
+static void
+log_drain(void)
+{
+	pthread_mutex_lock(&log_state.drain_lock);
+	if (log_state.ring == NULL) {
+		pthread_mutex_unlock(&log_state.drain_lock);
+		return;
+	}
+	size_t tail = atomic_load_explicit(&log_state.tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&log_state.head, memory_order_acquire);
+	while (tail != head) {
+		const unsigned char *data =
+			log_state.ring + (tail & (SC_LOG_RING_SIZE - 1));
+		struct log_record record;
+		memcpy(&record, data, offsetof(struct log_record, time));
+		if (record.level != SC_LOG_PADDING) {
+			memcpy(&record, data, sizeof(record));
+			log_print(record.level, &record.time, record.fmt,
+					  data + sizeof(record), record.size - sizeof(record));
+		}
+		tail += record.size;
+	}
+	atomic_store_explicit(&log_state.tail, tail, memory_order_release);
+
+	unsigned int dropped = atomic_exchange(&log_state.dropped, 0);
+	if (dropped > 0) {
+		fprintf(log_stream(SC_LOG_ERROR), "log: %u messages dropped\n",
+				dropped);
+	}
+	fflush(log_stream(SC_LOG_INFO));
+	fflush(log_stream(SC_LOG_ERROR));
+	pthread_mutex_unlock(&log_state.drain_lock);
+}
+
+static bool
+log_push(const unsigned char *record, size_t size)
+{
+	size_t head = atomic_load_explicit(&log_state.head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&log_state.tail, memory_order_acquire);
+	size_t offset = head & (SC_LOG_RING_SIZE - 1);
+	// records don't wrap, the end of the ring is skipped instead
+	size_t padding =
+		SC_LOG_RING_SIZE - offset < size ? SC_LOG_RING_SIZE - offset : 0;
+	size_t used = head - tail;
+	if (SC_LOG_RING_SIZE - used < padding + size) {
+		return false;
+	}
+	if (padding > 0) {
+		struct log_record pad = {
+			.size = padding,
+			.level = SC_LOG_PADDING,
+		};
+		memcpy(log_state.ring + offset, &pad,
+			   offsetof(struct log_record, time));
+		head += padding;
+		offset = 0;
+	}
+	memcpy(log_state.ring + offset, record, size);
+	atomic_store_explicit(&log_state.head, head + size, memory_order_release);
+
+	if (log_state.background && used <= SC_LOG_RING_SIZE / 2 &&
+		used + padding + size > SC_LOG_RING_SIZE / 2) {
+		// half full, don't wait for the next interval
+		pthread_cond_signal(&log_state.wake);
+	}
+	return true;
+}
+
+void
+sc_log_write(enum sc_log_level level, const char *fmt, ...)
+{
+	va_list args;
+	if (!log_state.initialized ||
+		!pthread_equal(pthread_self(), log_state.producer)) {
+		va_start(args, fmt);
+		vfprintf(log_stream(level), fmt, args);
+		va_end(args);
+		return;
+	}
+
+	union {
+		unsigned char bytes[SC_LOG_RECORD_MAX];
+		max_align_t align;
+	} buf;
+	struct log_record record = {
+		.level = level,
+		.fmt = fmt,
+	};
+	clock_gettime(CLOCK_MONOTONIC, &record.time);
+
+	va_start(args, fmt);
+	size_t len = log_encode_args(buf.bytes + sizeof(record),
+								 sizeof(buf.bytes) - sizeof(record), fmt, args);
+	va_end(args);
+
+	record.size = (sizeof(record) + len + 7) & ~(size_t) 7;
+	memcpy(buf.bytes, &record, sizeof(record));
+	bool pushed = log_push(buf.bytes, record.size);
+	if (!pushed && level == SC_LOG_ERROR) {
+		log_drain();
+		pushed = log_push(buf.bytes, record.size);
+	}
+	if (!pushed) {
+		// never block the compositor on its log
+		atomic_fetch_add(&log_state.dropped, 1);
+	}
+	if (level == SC_LOG_ERROR) {
+		// out before returning, with what came before it: the last errors
+		// are the ones that matter when the compositor goes down next
+		log_drain();
+	}
+}
+
+static void *
+log_thread(void *data)
+{
+	pthread_mutex_lock(&log_state.wake_lock);
+	while (!atomic_load(&log_state.stop)) {
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += SC_LOG_FLUSH_INTERVAL_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait(&log_state.wake, &log_state.wake_lock,
+							   &deadline);
+		log_drain();
+	}
+	pthread_mutex_unlock(&log_state.wake_lock);
+	return NULL;
+}
+
+bool
+sc_log_init(enum sc_log_level level, bool background)
+{
+	if (log_state.initialized) {
+		sc_log_level = level;
+		return true;
+	}
+	sc_log_level = level;
+	log_state.ring = malloc(SC_LOG_RING_SIZE);
+	if (log_state.ring == NULL) {
+		return false;
+	}
+	atomic_init(&log_state.head, 0);
+	atomic_init(&log_state.tail, 0);
+	atomic_init(&log_state.dropped, 0);
+	atomic_init(&log_state.stop, false);
+	clock_gettime(CLOCK_MONOTONIC, &log_state.start);
+	log_state.producer = pthread_self();
+
+	log_state.background = background;
+	if (background &&
+		pthread_create(&log_state.thread, NULL, log_thread, NULL) != 0) {
+		// flushed by sc_log_flush only
+		log_state.background = false;
+	}
+	log_state.initialized = true;
+	atexit(sc_log_finish);
+	return true;
+}
+
+void
+sc_log_finish(void)
+{
+	if (!log_state.initialized) {
+		return;
+	}
+	if (log_state.background) {
+		atomic_store(&log_state.stop, true);
+		pthread_cond_signal(&log_state.wake);
+		pthread_join(log_state.thread, NULL);
+		log_state.background = false;
+	}
+	log_drain();
+	log_state.initialized = false;
+
+	pthread_mutex_lock(&log_state.drain_lock);
+	free(log_state.ring);
+	log_state.ring = NULL;
+	pthread_mutex_unlock(&log_state.drain_lock);
+}
+
+void
+sc_log_flush(void)
+{
+	log_drain();
+}
+
+bool
+sc_log_level_from_name(const char *name, enum sc_log_level *level)
+{
+	if (strcmp(name, "error") == 0) {
+		*level = SC_LOG_ERROR;
+	} else if (strcmp(name, "info") == 0) {
+		*level = SC_LOG_INFO;
+	} else if (strcmp(name, "debug") == 0) {
+		*level = SC_LOG_DEBUG;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void
+sc_log_set_output(FILE *out, FILE *err)
+{
+	pthread_mutex_lock(&log_state.drain_lock);
+	log_state.out = out;
+	log_state.err = err;
+	pthread_mutex_unlock(&log_state.drain_lock);
+}
@@ -0,0 +1,37 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+
+#include "sc_name_list.h"
+
+bool
+sc_name_list_contains(const char *list, const char *name)
+{
+	if (list == NULL || name == NULL) {
+		return false;
+	}
+	size_t name_len = strlen(name);
+	const char *start = list;
+	while (*start != '\0') {
+		const char *end = strchr(start, ',');
+		if (end == NULL) {
+			end = start + strlen(start);
+		}
+		const char *last = end;
+		while (start < last && *start == ' ') {
+			start++;
+		}
+		while (last > start && last[-1] == ' ') {
+			last--;
+		}
+		size_t len = last - start;
+		if ((len == 1 && *start == '*') ||
+			(len == name_len && len > 0 && strncmp(start, name, len) == 0)) {
+			return true;
+		}
+		if (*end == '\0') {
+			break;
+		}
+		start = end + 1;
+	}
+	return false;
+}
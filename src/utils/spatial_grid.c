@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdlib.h>
+
+#include "sc_spatial_grid.h"
+
+void
+sc_spatial_grid_init(struct sc_spatial_grid *grid)
+{
+	for (int i = 0; i < SC_SPATIAL_GRID_BUCKETS; i++) {
+		grid->buckets[i] = NULL;
+	}
+}
+
+void
+sc_spatial_grid_finish(struct sc_spatial_grid *grid)
+{
+	for (int i = 0; i < SC_SPATIAL_GRID_BUCKETS; i++) {
+		struct sc_spatial_grid_cell *cell = grid->buckets[i];
+		while (cell != NULL) {
+			struct sc_spatial_grid_cell *next = cell->next;
+			free(cell->entries);
+			free(cell);
+			cell = next;
+		}
+		grid->buckets[i] = NULL;
+	}
+}
+
+static int
+grid_coord(double v)
+{
+	return (int) floor(v / SC_SPATIAL_GRID_CELL_SIZE);
+}
+
+static unsigned int
+grid_hash(int cx, int cy)
+{
+	return ((unsigned int) cx * 73856093u ^ (unsigned int) cy * 19349663u) %
+		   SC_SPATIAL_GRID_BUCKETS;
+}
+
+static struct sc_spatial_grid_cell *
+grid_cell(struct sc_spatial_grid *grid, int cx, int cy, bool create)
+{
+	unsigned int bucket = grid_hash(cx, cy);
+	struct sc_spatial_grid_cell *cell;
+	for (cell = grid->buckets[bucket]; cell != NULL; cell = cell->next) {
+		if (cell->cx == cx && cell->cy == cy) {
+			return cell;
+		}
+	}
+	if (!create) {
+		return NULL;
+	}
+	cell = calloc(1, sizeof(struct sc_spatial_grid_cell));
+	if (cell == NULL) {
+		return NULL;
+	}
+	cell->cx = cx;
+	cell->cy = cy;
+	cell->next = grid->buckets[bucket];
+	grid->buckets[bucket] = cell;
+	return cell;
+}
+
+static bool
+cell_add(struct sc_spatial_grid_cell *cell, struct sc_spatial_grid_entry *entry)
+{
+	if (cell->len == cell->cap) {
+		size_t cap = cell->cap == 0 ? 4 : cell->cap * 2;
+		struct sc_spatial_grid_entry **entries =
+			realloc(cell->entries, cap * sizeof(*entries));
+		if (entries == NULL) {
+			return false;
+		}
+		cell->entries = entries;
+		cell->cap = cap;
+	}
+	cell->entries[cell->len++] = entry;
+	return true;
+}
+
+static void
+cell_remove(struct sc_spatial_grid_cell *cell,
+			struct sc_spatial_grid_entry *entry)
+{
+	for (size_t i = 0; i < cell->len; i++) {
+		if (cell->entries[i] == entry) {
+			cell->entries[i] = cell->entries[--cell->len];
+			return;
+		}
+	}
+}
+
+void
+sc_spatial_grid_remove(struct sc_spatial_grid *grid,
+					   struct sc_spatial_grid_entry *entry)
+{
+	if (!entry->indexed) {
+		return;
+	}
+	for (int cy = entry->cy0; cy <= entry->cy1; cy++) {
+		for (int cx = entry->cx0; cx <= entry->cx1; cx++) {
+			struct sc_spatial_grid_cell *cell = grid_cell(grid, cx, cy, false);
+			if (cell != NULL) {
+				cell_remove(cell, entry);
+			}
+		}
+	}
+	entry->indexed = false;
+}
+
+bool
+sc_spatial_grid_update(struct sc_spatial_grid *grid,
+					   struct sc_spatial_grid_entry *entry,
+					   const struct wlr_box *box, uint32_t z)
+{
+	entry->box = *box;
+	entry->z = z;
+	if (box->width <= 0 || box->height <= 0) {
+		sc_spatial_grid_remove(grid, entry);
+		return true;
+	}
+
+	int cx0 = grid_coord(box->x);
+	int cy0 = grid_coord(box->y);
+	int cx1 = grid_coord(box->x + box->width - 1);
+	int cy1 = grid_coord(box->y + box->height - 1);
+	if (entry->indexed && entry->cx0 == cx0 && entry->cy0 == cy0 &&
+		entry->cx1 == cx1 && entry->cy1 == cy1) {
+		// moved within the same cells, most motion events end here
+		return true;
+	}
+
+	sc_spatial_grid_remove(grid, entry);
+	entry->cx0 = cx0;
+	entry->cy0 = cy0;
+	entry->cx1 = cx1;
+	entry->cy1 = cy1;
+	entry->indexed = true;
+	for (int cy = cy0; cy <= cy1; cy++) {
+		for (int cx = cx0; cx <= cx1; cx++) {
+			struct sc_spatial_grid_cell *cell = grid_cell(grid, cx, cy, true);
+			if (cell == NULL || !cell_add(cell, entry)) {
+				// removing from cells the entry wasn't added to is harmless
+				sc_spatial_grid_remove(grid, entry);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+size_t
+sc_spatial_grid_query(struct sc_spatial_grid *grid, double x, double y,
+					  struct sc_spatial_grid_entry **hits, size_t max)
+{
+	struct sc_spatial_grid_cell *cell =
+		grid_cell(grid, grid_coord(x), grid_coord(y), false);
+	if (cell == NULL) {
+		return 0;
+	}
+	size_t len = 0;
+	for (size_t i = 0; i < cell->len; i++) {
+		struct sc_spatial_grid_entry *entry = cell->entries[i];
+		struct wlr_box *box = &entry->box;
+		if (x < box->x || y < box->y || x >= box->x + box->width ||
+			y >= box->y + box->height) {
+			continue;
+		}
+		// insertion sort, a cell holds a handful of entries
+		size_t j = len < max ? len++ : max;
+		while (j > 0 && hits[j - 1]->z < entry->z) {
+			if (j < max) {
+				hits[j] = hits[j - 1];
+			}
+			j--;
+		}
+		if (j < max) {
+			hits[j] = entry;
+		}
+	}
+	return len;
+}
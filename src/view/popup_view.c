@@ -28,6 +28,7 @@ xdg_popup_unmap(struct wl_listener *listener, void *data)
 	view->mapped = false;
 	view->frame.x = popup_view->xdg_popup->geometry.x;
 	view->frame.y = popup_view->xdg_popup->geometry.y;
+	sc_view_update_index(view);
 	sc_view_damage_whole(view->parent);
 }
 
@@ -40,6 +41,7 @@ xdg_popup_destroy(struct wl_listener *listener, void *data)
 
 	struct sc_view *view = (struct sc_view *) popup_view;
 
+	sc_view_remove_index(view);
 	wl_list_remove(&view->link);
 	wl_list_remove(&popup_view->on_map.link);
 	wl_list_remove(&popup_view->on_unmap.link);
@@ -78,6 +80,7 @@ sc_popup_unconstrain(struct sc_popup_view *popup_view)
 
 	view->frame.x = sx;
 	view->frame.y = sy;
+	sc_view_update_index(view);
 }
 
 static void
@@ -106,8 +109,18 @@ xdg_popup_popup_new(struct wl_listener *listener, void *data)
 	wl_list_insert(&view->children, &subview->link);
 }
 
+static struct wlr_surface *
+popup_surface_at(struct sc_view *view, double x, double y, double *sx,
+				 double *sy)
+{
+	struct sc_point p = {.x = 0, .y = 0};
+	sc_view_get_absolute_position(view, &p);
+	return wlr_surface_surface_at(view->surface, x - p.x, y - p.y, sx, sy);
+}
+
 static struct sc_view_impl popup_view_impl = {
 	.commit = popup_commit,
+	.surface_at = popup_surface_at,
 };
 
 struct sc_popup_view *
@@ -123,6 +136,7 @@ sc_popup_view_create(struct wlr_xdg_popup *xdg_popup, struct sc_view *parent)
 	view->parent = parent;
 	view->compositor = parent->compositor;
 	view->output = parent->output;
+	view->workspace = parent->workspace;
 	sc_view_init(view, SC_VIEW_POPUP, &popup_view_impl,
 				 xdg_popup->base->surface);
 	view->mapped = true;
@@ -25,6 +25,8 @@ layer_map(struct wl_listener *listener, void *data)
 
 	sc_view_set_output(view, output);
 
+	view->frame.x = layer_view->layer_surface->current.position.x;
+	view->frame.y = layer_view->layer_surface->current.position.y;
 	view->frame.width = layer_view->layer_surface->current.bounds.width;
 	view->frame.height = layer_view->layer_surface->current.bounds.height;
 
@@ -62,7 +64,6 @@ layer_destroy(struct wl_listener *listener, void *data)
 static void
 layer_surface_commit(struct wl_listener *listener, void *data)
 {
-	DLOG("layer_surface_commit\n");
 	struct sc_layer_view *layer_view =
 	 	wl_container_of(listener, layer_view, on_surface_commit);
 
@@ -75,7 +76,6 @@ layer_surface_commit(struct wl_listener *listener, void *data)
 		//sc_layer_surface_v1_configure(layer_surface, view->frame.width,
 		//							   view->frame.height);
 	}
-	LOG("add damage\n");
 	sc_output_add_damage_from_view(view->output, view, true);
 }
 
@@ -92,9 +92,18 @@ layer_for_each_popup_surface(struct sc_view *view,
 {
 }
 
+static struct wlr_surface *
+layer_surface_at(struct sc_view *view, double x, double y, double *sx,
+				 double *sy)
+{
+	return wlr_surface_surface_at(view->surface, x - view->frame.x,
+								  y - view->frame.y, sx, sy);
+}
+
 static struct sc_view_impl layer_view_impl = {
 //	.for_each_surface = layer_for_each_surface,
 	.for_each_popup_surface = layer_for_each_popup_surface,
+	.surface_at = layer_surface_at,
 };
 
 
@@ -1,12 +1,18 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <wlr/util/edges.h>
 
 #include "log.h"
 #include "sc_compositor_workspace.h"
+#include "sc_config.h"
+#include "sc_name_list.h"
 #include "sc_popup_view.h"
+#include "sc_thumbnail.h"
 #include "sc_toplevel_view.h"
 #include "sc_view.h"
 
+extern struct sc_configuration configuration;
+
 static void
 xdg_toplevel_map(struct wl_listener *listener, void *data)
 {
@@ -24,6 +30,9 @@ xdg_toplevel_map(struct wl_listener *listener, void *data)
 	wlr_xdg_surface_get_geometry(toplevel_view->xdg_surface, &geometry);
 
 	sc_view_map(&toplevel_view->super);
+	toplevel_view->low_latency =
+		sc_name_list_contains(configuration.low_latency_app_ids,
+							  toplevel_view->xdg_surface->toplevel->app_id);
 
 	struct sc_view *view = (struct sc_view *) toplevel_view;
 
@@ -31,6 +40,9 @@ xdg_toplevel_map(struct wl_listener *listener, void *data)
 	view->frame.height = geometry.height;
 
 	sc_compositor_add_toplevel(toplevel_view->super.compositor, toplevel_view);
+
+	toplevel_view->thumbnail = sc_thumbnail_create_for_view(
+		view->compositor, view, SC_THUMBNAIL_SIZE, SC_THUMBNAIL_SIZE);
 }
 
 static void
@@ -41,6 +53,8 @@ xdg_toplevel_unmap(struct wl_listener *listener, void *data)
 		wl_container_of(listener, toplevel_view, on_unmap);
 	struct sc_view *view = (struct sc_view *) toplevel_view;
 	wl_list_remove(&toplevel_view->link);
+	sc_thumbnail_destroy(toplevel_view->thumbnail);
+	toplevel_view->thumbnail = NULL;
 	sc_view_unmap(view);
 }
 
@@ -51,6 +65,9 @@ xdg_toplevel_destroy(struct wl_listener *listener, void *data)
 	struct sc_toplevel_view *toplevel_view =
 		wl_container_of(listener, toplevel_view, on_destroy);
 
+	sc_view_remove_index(&toplevel_view->super);
+	sc_thumbnails_forget_view(toplevel_view->super.compositor,
+							  &toplevel_view->super);
 	wl_list_remove(&toplevel_view->on_map.link);
 	wl_list_remove(&toplevel_view->on_unmap.link);
 	wl_list_remove(&toplevel_view->on_destroy.link);
@@ -110,6 +127,7 @@ activate(struct sc_view *view)
 	struct sc_toplevel_view *toplevel = (struct sc_toplevel_view *) view;
 
 	wlr_xdg_toplevel_set_activated(toplevel->xdg_surface, true);
+	sc_view_set_color_matrix(view, NULL);
 }
 
 static void
@@ -118,13 +136,92 @@ deactivate(struct sc_view *view)
 	struct sc_toplevel_view *toplevel = (struct sc_toplevel_view *) view;
 
 	wlr_xdg_toplevel_set_activated(toplevel->xdg_surface, false);
+
+	if (configuration.inactive_dim > 0.0f) {
+		float brightness = 1.0f - configuration.inactive_dim;
+		if (brightness < 0.0f) {
+			brightness = 0.0f;
+		}
+		struct sc_color_matrix dim = {
+			.matrix = {
+				brightness, 0.0f, 0.0f, 0.0f,
+				0.0f, brightness, 0.0f, 0.0f,
+				0.0f, 0.0f, brightness, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f,
+			},
+		};
+		sc_view_set_color_matrix(view, &dim);
+	}
+}
+
+static void
+toplevel_send_size(struct sc_toplevel_view *toplevel)
+{
+	if (toplevel->pending_width == toplevel->sent_width &&
+		toplevel->pending_height == toplevel->sent_height) {
+		return;
+	}
+	toplevel->configure_serial = wlr_xdg_toplevel_set_size(
+		toplevel->xdg_surface, toplevel->pending_width,
+		toplevel->pending_height);
+	toplevel->sent_width = toplevel->pending_width;
+	toplevel->sent_height = toplevel->pending_height;
+}
+
+void
+sc_toplevel_view_set_size(struct sc_toplevel_view *toplevel, int width,
+						  int height)
+{
+	toplevel->pending_width = width;
+	toplevel->pending_height = height;
+	if (toplevel->configure_serial != 0) {
+		// a slow client would fall further behind with every configure
+		return;
+	}
+	toplevel_send_size(toplevel);
 }
 
 static void
 toplevel_commit(struct sc_view *view)
 {
-	view->frame.width = view->surface->current.width;
-	view->frame.height = view->surface->current.height;
+	struct sc_toplevel_view *toplevel = (struct sc_toplevel_view *) view;
+	struct sc_compositor *compositor = view->compositor;
+
+	if (toplevel->configure_serial != 0 &&
+		(int32_t) (toplevel->xdg_surface->current.configure_serial -
+				   toplevel->configure_serial) >= 0) {
+		// this commit has the size we asked for, ask for the latest one
+		toplevel->configure_serial = 0;
+		toplevel_send_size(toplevel);
+	}
+
+	struct wlr_box old_box = view->index_entry.box;
+	int old_x = view->frame.x;
+	int old_y = view->frame.y;
+	// the window geometry, as on map: without the client side shadows
+	struct wlr_box geometry;
+	wlr_xdg_surface_get_geometry(toplevel->xdg_surface, &geometry);
+	view->frame.width = geometry.width;
+	view->frame.height = geometry.height;
+
+	if (compositor->grabbed_view == toplevel &&
+		compositor->cursor_mode == SC_CURSOR_RESIZE) {
+		// keep the edges opposite to the grabbed ones in place, using the
+		// size the client actually committed
+		struct wlr_box *grab = &compositor->grab_box;
+		if (compositor->resize_edges & WLR_EDGE_LEFT) {
+			view->frame.x = grab->x + grab->width - view->frame.width;
+		}
+		if (compositor->resize_edges & WLR_EDGE_TOP) {
+			view->frame.y = grab->y + grab->height - view->frame.height;
+		}
+	}
+	if (view->output != NULL && view->index_entry.indexed &&
+		(view->frame.x != old_x || view->frame.y != old_y)) {
+		sc_output_add_damage_box(view->output, &old_box);
+		sc_output_add_damage_from_view(view->output, view, true);
+		return;
+	}
 
 	if (view->parent != NULL) {
 		sc_output_add_damage_from_view(view->parent->output, view->parent,
@@ -157,6 +254,7 @@ sc_toplevel_view_create(struct wlr_xdg_surface *xdg_surface,
 
 	sc_view_init(view, SC_VIEW_TOPLEVEL, &toplvel_view_impl,
 				 xdg_surface->surface);
+	view->corner_radius = configuration.corner_radius;
 
 	toplevel_view->on_map.notify = xdg_toplevel_map;
 	wl_signal_add(&xdg_surface->events.map, &toplevel_view->on_map);
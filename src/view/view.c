@@ -6,8 +6,38 @@
 #include "sc_compositor.h"
 #include "sc_geometry.h"
 #include "sc_output.h"
+#include "sc_output_repaintdelay.h"
 #include "sc_skia.h"
+#include "sc_sync.h"
 #include "sc_view.h"
+#include "sc_wlr_layer_view.h"
+#include "sc_workspace.h"
+
+static bool
+view_box_equal(const struct wlr_box *a, const struct wlr_box *b)
+{
+	return a->x == b->x && a->y == b->y && a->width == b->width &&
+		   a->height == b->height;
+}
+
+static struct sc_view *
+view_root(struct sc_view *view)
+{
+	while (view->parent != NULL) {
+		view = view->parent;
+	}
+	return view;
+}
+
+/* the render lists of the outputs are rebuilt before the next frame */
+static void
+view_scene_changed(struct sc_view *view)
+{
+	view = view_root(view);
+	if (view->compositor != NULL) {
+		view->compositor->scene_serial++;
+	}
+}
 
 void
 view_surface_map_skia_image(struct sc_view *view)
@@ -22,26 +52,31 @@ view_surface_map_skia_image(struct sc_view *view)
 		// we need an output with a skia context to map a skia image
 		return;
 	}
-	if (texture) {
-		struct wlr_gles2_texture_attribs *tex_attribs =
-			malloc(sizeof(struct wlr_gles2_texture_attribs));
-		wlr_gles2_texture_get_attribs(texture, tex_attribs);
-
-		if (view->texture_attributes->target != tex_attribs->target ||
-			view->texture_attributes->tex != tex_attribs->tex ||
-			view->texture_attributes->width != texture->width ||
-			view->texture_attributes->height != texture->height) {
-			// we should create a new skia_image
-			view->texture_attributes->target = tex_attribs->target;
-			view->texture_attributes->tex = tex_attribs->tex;
-			view->texture_attributes->width = texture->width;
-			view->texture_attributes->height = texture->height;
-
-			skia_image_from_texture(output->skia, surface,
-									view->texture_attributes);
-		}
-		free(tex_attribs);
+	if (texture == NULL || output->skia == NULL) {
+		return;
+	}
+	struct wlr_gles2_texture_attribs tex_attribs;
+	wlr_gles2_texture_get_attribs(texture, &tex_attribs);
+
+	// For shm buffers wlroots writes only the damaged rectangles into the
+	// texture it already has, as long as the size and format don't change
+	// and nobody else holds a lock on the client buffer. The texture is then
+	// the same one and the skia image wrapping it stays valid: only rewrap
+	// when wlroots had to allocate a new texture.
+	if (view->texture_attributes->target == tex_attribs.target &&
+		view->texture_attributes->tex == tex_attribs.tex &&
+		view->texture_attributes->width == texture->width &&
+		view->texture_attributes->height == texture->height) {
+		return;
 	}
+	DLOG("view: wrapping texture %u %ux%u\n", tex_attribs.tex,
+		 texture->width, texture->height);
+	view->texture_attributes->target = tex_attribs.target;
+	view->texture_attributes->tex = tex_attribs.tex;
+	view->texture_attributes->width = texture->width;
+	view->texture_attributes->height = texture->height;
+
+	skia_image_from_texture(output->skia, surface, view->texture_attributes);
 }
 
 static void
@@ -49,20 +84,43 @@ view_surface_commit_handler(struct wl_listener *listener, void *data)
 {
 	struct sc_view *view = wl_container_of(listener, view, on_surface_commit);
 	view_surface_map_skia_image(view);
+	sc_sync_surface_commit(view->surface);
+
+	struct sc_view *root = view_root(view);
+	root->content_serial++;
+	if (root->workspace != NULL) {
+		root->workspace->content_serial++;
+	}
+	if (root->output != NULL && root->output->content_view == root) {
+		// paces the adaptive sync refresh and the low latency mode
+		sc_output_content_commit(root->output);
+	}
+
+	// the image is looked up when drawing, only the geometry is in the lists
+	bool scene_changed =
+		view->type == SC_VIEW_SCLAYER ||
+		(view->surface->current.committed & WLR_SURFACE_STATE_OPAQUE_REGION);
+	struct wlr_box old_frame = view->frame;
 
 	// subviews informations can be committed together with the parent
 	struct sc_view *subview;
 	wl_list_for_each (subview, &view->children, link) {
 		if (subview->subsurface) {
+			struct wlr_box old_subframe = subview->frame;
 			subview->frame.x = subview->subsurface->current.x;
 			subview->frame.y = subview->subsurface->current.y;
 			subview->frame.width = subview->surface->current.width;
 			subview->frame.height = subview->surface->current.height;
+			scene_changed |= !view_box_equal(&old_subframe, &subview->frame);
 		}
 	}
 
 	if (view->impl->commit) {
 		view->impl->commit(view);
+		if (scene_changed || !view_box_equal(&old_frame, &view->frame)) {
+			view_scene_changed(view);
+		}
+		sc_view_update_index(view);
 		return;
 	}
 
@@ -75,6 +133,9 @@ view_surface_commit_handler(struct wl_listener *listener, void *data)
 	}
 	view->frame.width = view->surface->current.width;
 	view->frame.height = view->surface->current.height;
+	if (scene_changed || !view_box_equal(&old_frame, &view->frame)) {
+		view_scene_changed(view);
+	}
 
 	if (view->parent != NULL) {
 		sc_output_add_damage_from_view(view->parent->output, view->parent,
@@ -82,6 +143,7 @@ view_surface_commit_handler(struct wl_listener *listener, void *data)
 	} else {
 		sc_output_add_damage_from_view(view->output, view, false);
 	}
+	sc_view_update_index(view);
 }
 
 static void
@@ -174,7 +236,7 @@ sc_view_init(struct sc_view *view, enum sc_view_type type,
 	}
 
 	view->surface = surface;
-	view->texture_attributes = malloc(sizeof(struct sc_texture_attributes));
+	view->texture_attributes = calloc(1, sizeof(struct sc_texture_attributes));
 	wl_list_init(&view->children);
 
 	view->on_surface_commit.notify = view_surface_commit_handler;
@@ -188,6 +250,7 @@ sc_view_init(struct sc_view *view, enum sc_view_type type,
 void
 sc_view_destroy(struct sc_view *view)
 {
+	view_scene_changed(view);
 	struct sc_view *subview;
 	wl_list_for_each (subview, &view->children, link) {
 		subview->parent = NULL;
@@ -196,6 +259,7 @@ sc_view_destroy(struct sc_view *view)
 	wl_list_remove(&view->on_subsurface_new.link);
 	wl_list_remove(&view->on_surface_commit.link);
 	wl_list_remove(&view->on_subview_destroy.link);
+	sc_view_remove_index(view);
 	free(view->texture_attributes);
 	free_skia_image(view->surface);
 }
@@ -248,6 +312,11 @@ sc_view_map(struct sc_view *view)
 	}
 	
 	sc_view_damage_whole(view);
+	if (view->stacking_serial == 0) {
+		sc_view_raise(view);
+	} else {
+		sc_view_update_index(view);
+	}
 }
 
 void
@@ -255,6 +324,100 @@ sc_view_unmap(struct sc_view *view)
 {
 	sc_view_damage_whole(view);
 	view->mapped = false;
+	sc_view_update_index(view);
+}
+
+static uint32_t stacking_serial = 0;
+
+static uint32_t
+view_stacking_band(struct sc_view *view)
+{
+	switch (view->type) {
+	case SC_VIEW_WLRLAYER: {
+		struct sc_wlr_layer_view *layer = (struct sc_wlr_layer_view *) view;
+		switch (layer->layer_surface->current.layer) {
+		case ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND:
+			return SC_STACKING_BACKGROUND;
+		case ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM:
+			return SC_STACKING_BOTTOM;
+		case ZWLR_LAYER_SHELL_V1_LAYER_TOP:
+			return SC_STACKING_TOP;
+		case ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY:
+			return SC_STACKING_OVERLAY;
+		}
+		return SC_STACKING_TOP;
+	}
+	case SC_VIEW_POPUP:
+		return SC_STACKING_POPUP;
+	case SC_VIEW_SCLAYER:
+		return SC_STACKING_SCLAYER;
+	default:
+		return SC_STACKING_TOPLEVEL;
+	}
+}
+
+static void
+view_index_update(struct sc_view *view, struct sc_spatial_grid *index)
+{
+	struct wlr_box box = {0};
+	if (view->mapped) {
+		struct sc_point p = {.x = 0, .y = 0};
+		sc_view_get_absolute_position(view, &p);
+		// the whole surface tree, subsurfaces can stick out of the frame
+		wlr_surface_get_extends(view->surface, &box);
+		box.x += p.x;
+		box.y += p.y;
+	}
+	view->index_entry.data = view;
+	uint32_t z = view_stacking_band(view) << 24 |
+				 (view->stacking_serial & 0xffffff);
+	// moved, resized, mapped, unmapped or restacked
+	if (view->index_entry.z != z ||
+		!view_box_equal(&view->index_entry.box, &box)) {
+		view_scene_changed(view);
+	}
+	sc_spatial_grid_update(index, &view->index_entry, &box, z);
+
+	// popups are positioned relative to their parent
+	struct sc_view *child;
+	wl_list_for_each (child, &view->children, link) {
+		if (child->type == SC_VIEW_POPUP) {
+			view_index_update(child, index);
+		}
+	}
+}
+
+void
+sc_view_update_index(struct sc_view *view)
+{
+	// subsurfaces are hit through the view they belong to
+	while (view->type == SC_VIEW_SUBVIEW && view->parent != NULL) {
+		view = view->parent;
+	}
+	if (view->workspace == NULL || view->type == SC_VIEW_SUBVIEW) {
+		return;
+	}
+	view->workspace->content_serial++;
+	view_index_update(view, &view->workspace->view_index);
+}
+
+void
+sc_view_remove_index(struct sc_view *view)
+{
+	if (view->workspace != NULL) {
+		if (view->index_entry.indexed) {
+			view_scene_changed(view);
+		}
+		sc_spatial_grid_remove(&view->workspace->view_index,
+							   &view->index_entry);
+	}
+}
+
+void
+sc_view_raise(struct sc_view *view)
+{
+	view->stacking_serial = ++stacking_serial;
+	sc_view_update_index(view);
 }
 void
 sc_view_for_each_surface(struct sc_view *view,
@@ -286,7 +449,9 @@ sc_view_for_each_popup_surface(struct sc_view *view,
 bool
 sc_view_is_visible(struct sc_view *view)
 {
-	return view->mapped;
+	// hidden workspaces are neither damaged nor repainted
+	return view->mapped && (view->workspace == NULL ||
+							view->workspace == view->compositor->current_workspace);
 }
 
 struct wlr_surface *
@@ -321,6 +486,22 @@ sc_view_activate(struct sc_view *view)
 	sc_view_damage_whole(view);
 }
 
+void
+sc_view_set_color_matrix(struct sc_view *view,
+						 const struct sc_color_matrix *color_matrix)
+{
+	if (color_matrix == NULL && !view->has_color_matrix) {
+		return;
+	}
+	view->has_color_matrix = color_matrix != NULL;
+	if (color_matrix != NULL) {
+		view->color_matrix = *color_matrix;
+	}
+	// the render lists keep a copy
+	view_scene_changed(view);
+	sc_view_damage_whole(view);
+}
+
 void
 sc_view_deactivate(struct sc_view *view)
 {
@@ -1,11 +1,41 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <string.h>
 
 #include "log.h"
 #include "sc_compositor_workspace.h"
+#include "sc_skia.h"
 #include "sc_wlr_layer_view.h"
 #include "sc_toplevel_view.h"
 #include "sc_view.h"
+#include "sc_workspace.h"
+
+static void
+layer_arrange_state(struct wlr_layer_surface_v1 *layer_surface,
+					struct sc_layer_arrange_state *state)
+{
+	struct wlr_layer_surface_v1_state *current = &layer_surface->current;
+	*state = (struct sc_layer_arrange_state){
+		.anchor = current->anchor,
+		.exclusive_zone = current->exclusive_zone,
+		.margin_top = current->margin.top,
+		.margin_right = current->margin.right,
+		.margin_bottom = current->margin.bottom,
+		.margin_left = current->margin.left,
+		.desired_width = current->desired_width,
+		.desired_height = current->desired_height,
+	};
+}
+
+static void
+layer_background_changed(struct sc_view *view)
+{
+	struct sc_wlr_layer_view *layer_view = (struct sc_wlr_layer_view *) view;
+	if (layer_view->layer == ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND &&
+		view->output != NULL && view->output->skia != NULL) {
+		skia_invalidate_background(view->output->skia);
+	}
+}
 
 static void
 layer_map(struct wl_listener *listener, void *data)
@@ -18,8 +48,10 @@ layer_map(struct wl_listener *listener, void *data)
 
 	struct sc_view *view = (struct sc_view *) layer_view;
 	sc_view_map(view);
+	layer_background_changed(view);
 
-	sc_compositor_add_wlr_layer(view->compositor, layer_view);
+	// its exclusive zone counts from now on
+	sc_wlr_layer_views_arrange(view->compositor, view->output);
 }
 
 static void
@@ -29,9 +61,12 @@ layer_unmap(struct wl_listener *listener, void *data)
 	struct sc_wlr_layer_view *layer_view =
 		wl_container_of(listener, layer_view, on_unmap);
 	struct sc_view *view = (struct sc_view *) layer_view;
-	view->mapped = false;
+	sc_view_unmap(view);
+	layer_background_changed(view);
 
-	wl_list_remove(&layer_view->link);
+	if (view->output != NULL) {
+		sc_wlr_layer_views_arrange(view->compositor, view->output);
+	}
 }
 
 static void
@@ -40,71 +75,191 @@ layer_destroy(struct wl_listener *listener, void *data)
 	DLOG("layer_destroy\n");
 	struct sc_wlr_layer_view *layer_view =
 		wl_container_of(listener, layer_view, on_destroy);
+	struct sc_view *view = (struct sc_view *) layer_view;
 
+	sc_view_remove_index(view);
+	wl_list_remove(&layer_view->link);
 	wl_list_remove(&layer_view->on_map.link);
 	wl_list_remove(&layer_view->on_unmap.link);
 	wl_list_remove(&layer_view->on_destroy.link);
+	if (layer_view->close_idle != NULL) {
+		wl_event_source_remove(layer_view->close_idle);
+	}
+	// the surface can outlive its role
+	wl_list_remove(&view->on_surface_commit.link);
+	wl_list_remove(&view->on_subsurface_new.link);
+	free(view->texture_attributes);
+	free_skia_image(view->surface);
 
 	free(layer_view);
 }
 
 static void
-layer_surface_commit(struct wl_listener *listener, void *data)
+layer_commit(struct sc_view *view)
 {
-	DLOG("layer_surface_commit\n");
-	struct sc_wlr_layer_view *layer_view =
-		wl_container_of(listener, layer_view, on_surface_commit);
-
-	struct sc_view *view = (struct sc_view *) layer_view;
-
+	struct sc_wlr_layer_view *layer_view = (struct sc_wlr_layer_view *) view;
 	struct wlr_layer_surface_v1 *layer_surface = layer_view->layer_surface;
-	if (view->mapped != layer_surface->mapped ||
-		(layer_surface->added && !layer_surface->configured)) {
+	if (view->output == NULL) {
+		return;
+	}
 
-		wlr_layer_surface_v1_configure(layer_surface, view->frame.width,
-									   view->frame.height);
+	bool arrange = !layer_view->configure_sent;
+	if (layer_surface->current.layer != layer_view->layer) {
+		layer_background_changed(view);
+		sc_view_damage_whole(view);
+		wl_list_remove(&layer_view->link);
+		sc_compositor_add_wlr_layer(view->compositor, layer_view);
+		arrange = true;
+	}
+	struct sc_layer_arrange_state state;
+	layer_arrange_state(layer_surface, &state);
+	if (memcmp(&state, &layer_view->arranged, sizeof(state)) != 0) {
+		arrange = true;
 	}
-	sc_output_add_damage_from_view(view->output, view, true);
+	if (arrange) {
+		sc_wlr_layer_views_arrange(view->compositor, view->output);
+	}
+
+	layer_background_changed(view);
+	sc_output_add_damage_from_view(view->output, view, false);
 }
 
-void
+static void
 layer_for_each_surface(struct sc_view *view,
-						  wlr_surface_iterator_func_t iterator, void *user_data)
+					   wlr_surface_iterator_func_t iterator, void *user_data)
 {
-	DLOG("layer_for_each_surface\n");
+	struct sc_wlr_layer_view *layer_view = (struct sc_wlr_layer_view *) view;
+	wlr_layer_surface_v1_for_each_surface(layer_view->layer_surface, iterator,
+										  user_data);
 }
 
-void
+static void
 layer_for_each_popup_surface(struct sc_view *view,
-								wlr_surface_iterator_func_t iterator,
-								void *user_data)
+							 wlr_surface_iterator_func_t iterator,
+							 void *user_data)
+{
+	struct sc_wlr_layer_view *layer_view = (struct sc_wlr_layer_view *) view;
+	wlr_layer_surface_v1_for_each_popup_surface(layer_view->layer_surface,
+												iterator, user_data);
+}
+
+static struct wlr_surface *
+layer_surface_at(struct sc_view *view, double x, double y, double *sx,
+				 double *sy)
 {
-	DLOG("layer_for_each_popup_surface\n");
+	struct sc_wlr_layer_view *layer_view = (struct sc_wlr_layer_view *) view;
+	return wlr_layer_surface_v1_surface_at(
+		layer_view->layer_surface, x - view->frame.x, y - view->frame.y, sx,
+		sy);
 }
 
 static struct sc_view_impl layer_view_impl = {
 	.for_each_surface = layer_for_each_surface,
 	.for_each_popup_surface = layer_for_each_popup_surface,
+	.surface_at = layer_surface_at,
+	.commit = layer_commit,
 };
 
+/* the surface may be in the middle of its commit, it's closed later */
+static void
+layer_close_idle(void *data)
+{
+	struct sc_wlr_layer_view *layer_view = data;
+	layer_view->close_idle = NULL;
+	wlr_layer_surface_v1_destroy(layer_view->layer_surface);
+}
+
+static void
+layer_arrange(struct sc_wlr_layer_view *layer_view, struct wlr_box *full,
+			  struct wlr_box *usable)
+{
+	struct sc_view *view = (struct sc_view *) layer_view;
+	struct wlr_layer_surface_v1 *layer_surface = layer_view->layer_surface;
+
+	layer_arrange_state(layer_surface, &layer_view->arranged);
+	// an unmapped surface gets its size but doesn't reserve its zone yet
+	struct wlr_box scratch = *usable;
+	struct wlr_box box;
+	if (!sc_layer_arrange_box(&layer_view->arranged, full,
+							  view->mapped ? usable : &scratch, &box)) {
+		if (layer_view->close_idle == NULL) {
+			ELOG("layer surface doesn't fit the output, closing it\n");
+			layer_view->close_idle = wl_event_loop_add_idle(
+				view->compositor->wl_event_loop, layer_close_idle,
+				layer_view);
+		}
+		return;
+	}
+
+	if (box.x != view->frame.x || box.y != view->frame.y ||
+		box.width != view->frame.width || box.height != view->frame.height) {
+		sc_view_damage_whole(view);
+		view->frame = box;
+		sc_view_damage_whole(view);
+		sc_view_update_index(view);
+		layer_background_changed(view);
+	}
+	if (!layer_view->configure_sent ||
+		layer_view->configure_width != box.width ||
+		layer_view->configure_height != box.height) {
+		wlr_layer_surface_v1_configure(layer_surface, box.width, box.height);
+		layer_view->configure_sent = true;
+		layer_view->configure_width = box.width;
+		layer_view->configure_height = box.height;
+	}
+}
+
+static void
+layers_arrange(struct sc_output *output, struct wl_list *layers,
+			   struct wlr_box *full, struct wlr_box *usable, bool exclusive)
+{
+	struct sc_wlr_layer_view *layer_view;
+	wl_list_for_each_reverse (layer_view, layers, link) {
+		if (layer_view->super.output != output ||
+			(layer_view->layer_surface->current.exclusive_zone > 0) !=
+				exclusive) {
+			continue;
+		}
+		layer_arrange(layer_view, full, usable);
+	}
+}
+
+void
+sc_wlr_layer_views_arrange(struct sc_compositor *compositor,
+						   struct sc_output *output)
+{
+	struct sc_workspace *workspace = compositor->current_workspace;
+	struct wl_list *layers[] = {
+		&workspace->layers_overlay,
+		&workspace->layers_top,
+		&workspace->layers_bottom,
+		&workspace->layers_background,
+	};
+	struct wlr_box full = *output->output_box;
+	struct wlr_box usable = full;
+
+	// the surfaces reserving a zone go first, from the topmost layer
+	for (size_t i = 0; i < sizeof(layers) / sizeof(layers[0]); i++) {
+		layers_arrange(output, layers[i], &full, &usable, true);
+	}
+	for (size_t i = 0; i < sizeof(layers) / sizeof(layers[0]); i++) {
+		layers_arrange(output, layers[i], &full, &usable, false);
+	}
+	output->usable_area = usable;
+}
 
 struct sc_wlr_layer_view *
 sc_wlr_layer_view_create(struct wlr_layer_surface_v1 *layer_surface,
-					 struct sc_compositor *compositor)
+						 struct sc_compositor *compositor,
+						 struct sc_output *output)
 {
 	DLOG("sc_wlr_layer_view_create\n");
 	struct sc_wlr_layer_view *layer_view = calloc(1, sizeof(struct sc_wlr_layer_view));
 	struct sc_view *view = (struct sc_view *) layer_view;
 
-	view->frame = (struct wlr_box){
-		.x = layer_surface->pending.margin.left,
-		.y = layer_surface->pending.margin.top,
-		.width = layer_surface->pending.desired_width,
-		.height = layer_surface->pending.desired_height,
-	};
-
 	view->compositor = compositor;
 	sc_view_init(view, SC_VIEW_WLRLAYER, &layer_view_impl, layer_surface->surface);
+	sc_view_set_output(view, output);
 
 	layer_view->layer_surface = layer_surface;
 
@@ -117,9 +272,8 @@ sc_wlr_layer_view_create(struct wlr_layer_surface_v1 *layer_surface,
 	layer_view->on_destroy.notify = layer_destroy;
 	wl_signal_add(&layer_surface->events.destroy, &layer_view->on_destroy);
 
-	layer_view->on_surface_commit.notify = layer_surface_commit;
-	wl_signal_add(&layer_surface->surface->events.commit,
-				  &layer_view->on_surface_commit);
+	// arranged from the first commit, before it maps
+	sc_compositor_add_wlr_layer(compositor, layer_view);
 
 	return layer_view;
 }
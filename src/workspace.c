@@ -13,6 +13,7 @@ sc_workspace_create()
 	wl_list_init(&workspace->layers_bottom);
 	wl_list_init(&workspace->layers_background);
 	wl_list_init(&workspace->sc_layers);
+	sc_spatial_grid_init(&workspace->view_index);
 
 	return workspace;
 }
@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_frame_timing.h"
+
+#define MS 1000000LL
+
+int
+main(int argc, char **argv)
+{
+	// 60Hz, 6ms to render: 16ms after the last refresh the deadline is gone
+	struct sc_frame_timing timing = {
+		.last_present = 1000 * MS,
+		.refresh = 16666667,
+		.render_time = 6,
+	};
+	assert(sc_frame_timing_delay_ms(&timing, 1000 * MS) == 10);
+	assert(sc_frame_timing_delay_ms(&timing, 1005 * MS) == 5);
+	assert(sc_frame_timing_delay_ms(&timing, 1012 * MS) < 1);
+	assert(sc_frame_timing_delay_ms(&timing, 1100 * MS) < 1);
+
+	// no render time, no delay
+	timing.render_time = 0;
+	assert(sc_frame_timing_delay_ms(&timing, 1000 * MS) == 0);
+
+	// adaptive sync: the commits of a 24fps video go out when they come
+	timing.render_time = 6;
+	timing.adaptive = true;
+	int64_t commits[] = {1000 * MS, 1041667000, 1083333000, 1125 * MS};
+	for (size_t i = 0; i < sizeof(commits) / sizeof(commits[0]); i++) {
+		timing.last_present = i > 0 ? commits[i - 1] : 0;
+		assert(sc_frame_timing_delay_ms(&timing, commits[i]) == 0);
+	}
+
+	// the average settles on the content rate, and restarts after a pause
+	int64_t average = 0;
+	for (int i = 0; i < 64; i++) {
+		average = sc_frame_timing_average(average, 40 * MS + (i % 2) * MS);
+	}
+	assert(average >= 40 * MS && average <= 41 * MS);
+	assert(sc_frame_timing_average(average, 2000 * MS) == 0);
+	assert(sc_frame_timing_average(0, 40 * MS) == 40 * MS);
+
+	// 48-144Hz panel: 24fps shown twice, 10fps five times, 60fps as is
+	int64_t min_frame = 6944444, max_frame = 20833334;
+	assert(sc_frame_timing_lfc_interval(41666667, min_frame, max_frame) ==
+		   20833333);
+	assert(sc_frame_timing_lfc_interval(100 * MS, min_frame, max_frame) ==
+		   20 * MS);
+	assert(sc_frame_timing_lfc_interval(16666667, min_frame, max_frame) == 0);
+
+	// 48-60Hz panel: 25fps fits twice, 30fps needs a range over 2x
+	assert(sc_frame_timing_lfc_interval(40 * MS, 16666667, 20833334) ==
+		   20 * MS);
+	assert(sc_frame_timing_lfc_interval(33333333, 16 * MS, 25 * MS) ==
+		   16666666);
+	assert(sc_frame_timing_lfc_interval(33333333, 17 * MS, 25 * MS) == 0);
+
+	// unknown content rate or range
+	assert(sc_frame_timing_lfc_interval(0, min_frame, max_frame) == 0);
+	assert(sc_frame_timing_lfc_interval(40 * MS, min_frame, 0) == 0);
+	return 0;
+}
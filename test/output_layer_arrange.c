@@ -0,0 +1,72 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_layer_arrange.h"
+
+int
+main(int argc, char **argv)
+{
+	struct wlr_box full = {.x = 0, .y = 0, .width = 1024, .height = 768};
+	struct wlr_box usable = full;
+	struct wlr_box box;
+
+	// a panel along the top edge reserves its height
+	struct sc_layer_arrange_state panel = {
+		.anchor = SC_LAYER_ANCHOR_TOP | SC_LAYER_ANCHOR_LEFT |
+				  SC_LAYER_ANCHOR_RIGHT,
+		.exclusive_zone = 30,
+		.desired_height = 30,
+	};
+	assert(sc_layer_arrange_box(&panel, &full, &usable, &box));
+	assert(box.x == 0 && box.y == 0 && box.width == 1024 && box.height == 30);
+	assert(usable.x == 0 && usable.y == 30);
+	assert(usable.width == 1024 && usable.height == 738);
+
+	// a dock on the left, with a margin, below the panel
+	struct sc_layer_arrange_state dock = {
+		.anchor = SC_LAYER_ANCHOR_LEFT,
+		.exclusive_zone = 48,
+		.margin_left = 4,
+		.desired_width = 48,
+		.desired_height = 300,
+	};
+	assert(sc_layer_arrange_box(&dock, &full, &usable, &box));
+	assert(box.x == 4 && box.width == 48);
+	assert(box.y == 30 + (738 / 2 - 150));
+	assert(usable.x == 52 && usable.width == 1024 - 52);
+	assert(usable.y == 30 && usable.height == 738);
+
+	// a wallpaper ignores the zones and fills the output
+	struct sc_layer_arrange_state wallpaper = {
+		.anchor = SC_LAYER_ANCHOR_TOP | SC_LAYER_ANCHOR_BOTTOM |
+				  SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_RIGHT,
+		.exclusive_zone = -1,
+	};
+	struct wlr_box before = usable;
+	assert(sc_layer_arrange_box(&wallpaper, &full, &usable, &box));
+	assert(box.x == 0 && box.y == 0 && box.width == 1024 && box.height == 768);
+	assert(usable.x == before.x && usable.width == before.width);
+
+	// a notification in the bottom right corner of what's left
+	struct sc_layer_arrange_state notification = {
+		.anchor = SC_LAYER_ANCHOR_BOTTOM | SC_LAYER_ANCHOR_RIGHT,
+		.margin_right = 10,
+		.margin_bottom = 10,
+		.desired_width = 200,
+		.desired_height = 80,
+	};
+	assert(sc_layer_arrange_box(&notification, &full, &usable, &box));
+	assert(box.x == 1024 - 200 - 10 && box.y == 768 - 80 - 10);
+	assert(usable.x == before.x && usable.height == before.height);
+
+	// stretched but squeezed to nothing by the margins
+	struct sc_layer_arrange_state squeezed = {
+		.anchor = SC_LAYER_ANCHOR_LEFT | SC_LAYER_ANCHOR_RIGHT,
+		.margin_left = 600,
+		.margin_right = 600,
+		.desired_height = 10,
+	};
+	assert(!sc_layer_arrange_box(&squeezed, &full, &usable, &box));
+	return 0;
+}
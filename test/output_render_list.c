@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_render_list.h"
+
+static struct sc_render_item *
+add_item(struct sc_render_list *list, size_t tree, int x, int y, int w, int h,
+		 bool opaque)
+{
+	struct sc_render_item *item = sc_render_list_add(list);
+	assert(item != NULL);
+	item->tree = tree;
+	item->box = (struct wlr_box){.x = x, .y = y, .width = w, .height = h};
+	if (opaque) {
+		item->opaque_box = item->box;
+	}
+	return item;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct sc_render_list list;
+	sc_render_list_init(&list);
+	struct wlr_box bounds = {.x = 0, .y = 0, .width = 100, .height = 100};
+
+	// a background, a window with a popup, a fullscreen opaque window
+	add_item(&list, 0, 0, 0, 100, 100, true);
+	list.background_len = 1;
+	add_item(&list, 1, 10, 10, 20, 20, false);
+	add_item(&list, 1, 20, 20, 10, 10, false);
+	add_item(&list, 3, 0, 0, 100, 100, true);
+	sc_render_list_cull(&list, &bounds);
+
+	// the background is cached apart, never culled
+	assert(!list.items[0].occluded && list.items[0].tree_visible);
+	assert(list.items[1].occluded && list.items[2].occluded);
+	assert(!list.items[1].tree_visible);
+	assert(!list.items[3].occluded && list.items[3].tree_visible);
+
+	// the last one covers the output alone
+	struct sc_view *view = (struct sc_view *) &list;
+	list.items[3].view = view;
+	assert(sc_render_list_fullscreen_view(&list, &bounds) == view);
+
+	// a translucent window on top hides nothing
+	list.items[3].opaque_box = (struct wlr_box){0};
+	sc_render_list_cull(&list, &bounds);
+	assert(!list.items[1].occluded && list.items[1].tree_visible);
+	assert(sc_render_list_fullscreen_view(&list, &bounds) == NULL);
+
+	// a popup sticking out keeps its tree visible
+	sc_render_list_reset(&list);
+	add_item(&list, 0, 10, 10, 20, 20, false);
+	add_item(&list, 0, 25, 25, 20, 20, false);
+	add_item(&list, 2, 0, 0, 40, 40, true);
+	sc_render_list_cull(&list, &bounds);
+	assert(list.items[0].occluded && !list.items[1].occluded);
+	assert(list.items[0].tree_visible);
+	assert(sc_render_list_fullscreen_view(&list, &bounds) == NULL);
+
+	// partly covered by two opaque windows, together they hide it
+	sc_render_list_reset(&list);
+	add_item(&list, 0, 10, 10, 20, 20, false);
+	add_item(&list, 1, 0, 0, 20, 40, true);
+	add_item(&list, 2, 20, 0, 20, 40, true);
+	sc_render_list_cull(&list, &bounds);
+	assert(list.items[0].occluded && !list.items[0].tree_visible);
+	assert(!list.items[1].occluded && !list.items[2].occluded);
+
+	// off the output, or empty
+	sc_render_list_reset(&list);
+	add_item(&list, 0, 100, 0, 20, 20, false);
+	add_item(&list, 1, -20, 50, 20, 20, false);
+	add_item(&list, 2, 50, 50, 0, 20, false);
+	add_item(&list, 3, 90, 90, 20, 20, false);
+	sc_render_list_cull(&list, &bounds);
+	assert(list.items[0].occluded && list.items[1].occluded);
+	assert(list.items[2].occluded && !list.items[3].occluded);
+
+	// the storage grows
+	sc_render_list_reset(&list);
+	for (int i = 0; i < 1000; i++) {
+		add_item(&list, i, i % 100, 0, 1, 1, false);
+	}
+	assert(list.len == 1000 && list.cap >= 1000);
+
+	sc_render_list_finish(&list);
+	assert(list.items == NULL && list.len == 0);
+	return 0;
+}
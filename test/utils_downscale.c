@@ -0,0 +1,54 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_downscale.h"
+
+int
+main(int argc, char **argv)
+{
+	struct sc_downscale_level levels[8];
+
+	// an output into a 240px box: drawn at half size, then halved twice
+	size_t count = sc_downscale_levels(1920, 1080, 240, 240, levels, 8);
+	assert(count == 3);
+	assert(levels[0].width == 960 && levels[0].height == 540);
+	assert(levels[1].width == 480 && levels[1].height == 270);
+	assert(levels[2].width == 240 && levels[2].height == 135);
+
+	// less than 2x smaller, a single draw
+	count = sc_downscale_levels(400, 300, 300, 300, levels, 8);
+	assert(count == 1);
+	assert(levels[0].width == 300 && levels[0].height == 225);
+
+	// the first draw shrinks by less than 2x, the others halve
+	count = sc_downscale_levels(1000, 500, 300, 300, levels, 8);
+	assert(count == 2);
+	assert(levels[0].width == 600 && levels[0].height == 300);
+	assert(levels[1].width == 300 && levels[1].height == 150);
+
+	// never scaled up
+	count = sc_downscale_levels(100, 50, 300, 300, levels, 8);
+	assert(count == 1);
+	assert(levels[0].width == 100 && levels[0].height == 50);
+
+	// no level is bigger than the source, no size goes under a pixel
+	count = sc_downscale_levels(4000, 3, 100, 100, levels, 8);
+	assert(count >= 1);
+	for (size_t i = 0; i < count; i++) {
+		assert(levels[i].width >= 1 && levels[i].width <= 4000);
+		assert(levels[i].height >= 1 && levels[i].height <= 3);
+	}
+	assert(levels[count - 1].width == 100 && levels[count - 1].height == 1);
+
+	// out of levels, the first draw shrinks more
+	count = sc_downscale_levels(4096, 4096, 16, 16, levels, 2);
+	assert(count == 2);
+	assert(levels[0].width == 32 && levels[1].width == 16);
+
+	assert(sc_downscale_levels(0, 10, 10, 10, levels, 8) == 0);
+	assert(sc_downscale_levels(10, 10, 10, 0, levels, 8) == 0);
+	assert(sc_downscale_levels(10, 10, 10, 10, levels, 0) == 0);
+
+	return 0;
+}
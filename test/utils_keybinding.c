@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_keybinding.h"
+
+#define SHIFT 1
+#define CAPS 2
+#define CTRL 4
+#define ALT 8
+
+static int quit_calls = 0;
+static int other_calls = 0;
+
+static void
+quit(struct sc_compositor *compositor)
+{
+	quit_calls++;
+}
+
+static void
+other(struct sc_compositor *compositor)
+{
+	other_calls++;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct sc_keybindings bindings;
+	sc_keybindings_init(&bindings, SHIFT | CTRL | ALT);
+
+	// nothing bound, nothing to look up
+	assert(!sc_keybindings_may_match(&bindings, 0));
+	assert(!sc_keybindings_may_match(&bindings, ALT));
+	assert(sc_keybindings_find(&bindings, ALT, XKB_KEY_q) == NULL);
+
+	assert(sc_keybindings_add(&bindings, ALT, XKB_KEY_q, quit));
+	assert(sc_keybindings_add(&bindings, ALT | CTRL, XKB_KEY_F1, other));
+
+	struct sc_keybinding *binding =
+		sc_keybindings_find(&bindings, ALT, XKB_KEY_q);
+	assert(binding != NULL);
+	binding->action(NULL);
+	assert(quit_calls == 1);
+
+	// lock keys are masked out
+	assert(sc_keybindings_find(&bindings, ALT | CAPS, XKB_KEY_q) == binding);
+	assert(sc_keybindings_may_match(&bindings, ALT | CAPS));
+
+	// modifiers match exactly
+	assert(sc_keybindings_find(&bindings, CTRL, XKB_KEY_q) == NULL);
+	assert(sc_keybindings_find(&bindings, ALT | CTRL, XKB_KEY_q) == NULL);
+	assert(sc_keybindings_find(&bindings, ALT, XKB_KEY_F1) == NULL);
+	assert(sc_keybindings_find(&bindings, ALT | CTRL, XKB_KEY_F1) != NULL);
+
+	// plain typing skips the keysym lookup
+	assert(!sc_keybindings_may_match(&bindings, 0));
+	assert(!sc_keybindings_may_match(&bindings, SHIFT));
+	assert(!sc_keybindings_may_match(&bindings, CAPS));
+	assert(sc_keybindings_may_match(&bindings, ALT | CTRL));
+
+	// binding a combination again replaces its action
+	assert(sc_keybindings_add(&bindings, ALT, XKB_KEY_q, other));
+	sc_keybindings_find(&bindings, ALT, XKB_KEY_q)->action(NULL);
+	assert(quit_calls == 1 && other_calls == 1);
+
+	assert(sc_keybindings_add(&bindings, 0, XKB_KEY_Return, quit));
+	assert(sc_keybindings_may_match(&bindings, 0));
+
+	// many bindings share the buckets
+	for (xkb_keysym_t sym = 0x1000; sym < 0x1400; sym++) {
+		assert(sc_keybindings_add(&bindings, CTRL, sym, quit));
+	}
+	for (xkb_keysym_t sym = 0x1000; sym < 0x1400; sym++) {
+		binding = sc_keybindings_find(&bindings, CTRL, sym);
+		assert(binding != NULL && binding->sym == sym);
+		assert(sc_keybindings_find(&bindings, SHIFT, sym) == NULL);
+	}
+
+	sc_keybindings_finish(&bindings);
+	assert(sc_keybindings_find(&bindings, ALT, XKB_KEY_q) == NULL);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "log.h"
+
+static char *out_buf, *err_buf;
+static size_t out_len, err_len;
+static FILE *out, *err;
+
+static void
+open_streams(void)
+{
+	out = open_memstream(&out_buf, &out_len);
+	err = open_memstream(&err_buf, &err_len);
+	assert(out != NULL && err != NULL);
+	sc_log_set_output(out, err);
+}
+
+static void
+close_streams(void)
+{
+	sc_log_set_output(NULL, NULL);
+	fclose(out);
+	fclose(err);
+}
+
+/* the output without the timestamps */
+static void
+strip_timestamps(char *buf)
+{
+	char *dst = buf;
+	char *src = buf;
+	bool line_start = true;
+	while (*src != '\0') {
+		if (line_start && *src == '[') {
+			src = strstr(src, "] ");
+			assert(src != NULL);
+			src += 2;
+		}
+		line_start = *src == '\n';
+		*dst++ = *src++;
+	}
+	*dst = '\0';
+}
+
+int
+main(int argc, char **argv)
+{
+	assert(sc_log_init(SC_LOG_INFO, false));
+	open_streams();
+
+	// nothing is formatted before the flush
+	char name[16] = "view";
+	LOG("%s %d %u %ld %lld %zu %x %5.2f %c %% %-4s|\n", name, -3, 7u,
+		-100000L, 1LL << 40, (size_t) 42, 0xbeefu, 3.14159, 'z', "ab");
+	strcpy(name, "gone");
+	LOG("%*d|%.*s|%hhd|%hx\n", 4, 9, 2, "abcdef", (signed char) -1,
+		(unsigned short) 0xffff);
+	LOG("no newline, ");
+	LOG("same line\n");
+	DLOG("debug is above the level\n");
+	fflush(out);
+	assert(out_len == 0);
+
+	sc_log_flush();
+	fflush(out);
+	fflush(err);
+	strip_timestamps(out_buf);
+	strip_timestamps(err_buf);
+	assert(strcmp(out_buf, "view -3 7 -100000 1099511627776 42 beef  3.14 z % "
+						   "ab  |\n"
+						   "   9|ab|-1|ffff\n"
+						   "no newline, same line\n") == 0);
+	assert(err_len == 0);
+	close_streams();
+	free(out_buf);
+	free(err_buf);
+
+	// errors are out when ELOG returns, after what was queued before them
+	open_streams();
+	LOG("before\n");
+	ELOG("error %d\n", 1);
+	strip_timestamps(out_buf);
+	strip_timestamps(err_buf);
+	assert(strcmp(out_buf, "before\n") == 0);
+	assert(strcmp(err_buf, "error 1\n") == 0);
+	close_streams();
+	free(out_buf);
+	free(err_buf);
+
+	// a full ring drops records instead of blocking, and says so
+	open_streams();
+	char long_string[512];
+	memset(long_string, 'x', sizeof(long_string) - 1);
+	long_string[sizeof(long_string) - 1] = '\0';
+	for (int i = 0; i < 1024; i++) {
+		LOG("%d %s\n", i, long_string);
+	}
+	sc_log_flush();
+	fflush(out);
+	fflush(err);
+	assert(strstr(out_buf, "0 xxx") != NULL);
+	assert(strstr(err_buf, "messages dropped") != NULL);
+	close_streams();
+	free(out_buf);
+	free(err_buf);
+
+	// strings longer than a record are cut, never overflow
+	open_streams();
+	char huge[4096];
+	memset(huge, 'y', sizeof(huge) - 1);
+	huge[sizeof(huge) - 1] = '\0';
+	LOG("%s|%d\n", huge, 5);
+	sc_log_flush();
+	fflush(out);
+	assert(strstr(out_buf, "yyy") != NULL);
+	assert(strstr(out_buf, "<truncated>") != NULL);
+	close_streams();
+	free(out_buf);
+	free(err_buf);
+
+	enum sc_log_level level;
+	assert(sc_log_level_from_name("debug", &level) && level == SC_LOG_DEBUG);
+	assert(!sc_log_level_from_name("verbose", &level));
+
+	sc_log_finish();
+	return 0;
+}
@@ -0,0 +1,28 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sc_name_list.h"
+
+int
+main(int argc, char **argv)
+{
+	const char *list = "org.example.Sim, steam_app_1234 ,xplane";
+	assert(sc_name_list_contains(list, "org.example.Sim"));
+	assert(sc_name_list_contains(list, "steam_app_1234"));
+	assert(sc_name_list_contains(list, "xplane"));
+
+	// whole names only
+	assert(!sc_name_list_contains(list, "org.example"));
+	assert(!sc_name_list_contains(list, "xplane2"));
+	assert(!sc_name_list_contains(list, ""));
+
+	// empty entries match nothing, a star anything
+	assert(!sc_name_list_contains(",, ,", "a"));
+	assert(!sc_name_list_contains("", "a"));
+	assert(sc_name_list_contains("a, *", "b"));
+
+	assert(!sc_name_list_contains(NULL, "a"));
+	assert(!sc_name_list_contains("a", NULL));
+	return 0;
+}
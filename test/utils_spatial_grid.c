@@ -0,0 +1,55 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+
+#include "log.h"
+#include "sc_spatial_grid.h"
+
+int
+main(int argc, char **argv)
+{
+	struct sc_spatial_grid grid;
+	sc_spatial_grid_init(&grid);
+
+	struct sc_spatial_grid_entry below = {0}, above = {0}, far = {0};
+	struct wlr_box box = {.x = 0, .y = 0, .width = 800, .height = 600};
+	assert(sc_spatial_grid_update(&grid, &below, &box, 1));
+	box = (struct wlr_box){.x = 100, .y = 100, .width = 200, .height = 200};
+	assert(sc_spatial_grid_update(&grid, &above, &box, 2));
+	box = (struct wlr_box){.x = -5000, .y = 3000, .width = 10, .height = 10};
+	assert(sc_spatial_grid_update(&grid, &far, &box, 3));
+
+	// hits come highest z first
+	struct sc_spatial_grid_entry *hits[4];
+	assert(sc_spatial_grid_query(&grid, 150, 150, hits, 4) == 2);
+	assert(hits[0] == &above && hits[1] == &below);
+	assert(sc_spatial_grid_query(&grid, 500, 500, hits, 4) == 1);
+	assert(hits[0] == &below);
+	assert(sc_spatial_grid_query(&grid, 800, 10, hits, 4) == 0);
+	assert(sc_spatial_grid_query(&grid, -4995, 3005, hits, 4) == 1);
+	assert(hits[0] == &far);
+
+	// only max hits are stored, still the topmost ones
+	assert(sc_spatial_grid_query(&grid, 150, 150, hits, 1) == 1);
+	assert(hits[0] == &above);
+
+	// raising and moving
+	assert(sc_spatial_grid_update(&grid, &below, &below.box, 5));
+	assert(sc_spatial_grid_query(&grid, 150, 150, hits, 4) == 2);
+	assert(hits[0] == &below);
+	box = (struct wlr_box){.x = 1000, .y = 1000, .width = 200, .height = 200};
+	assert(sc_spatial_grid_update(&grid, &above, &box, 2));
+	assert(sc_spatial_grid_query(&grid, 150, 150, hits, 4) == 1);
+	assert(sc_spatial_grid_query(&grid, 1100, 1100, hits, 4) == 1);
+	assert(hits[0] == &above);
+
+	// empty boxes and removed entries are not found
+	box = (struct wlr_box){.x = 1000, .y = 1000, .width = 0, .height = 0};
+	assert(sc_spatial_grid_update(&grid, &above, &box, 2));
+	assert(sc_spatial_grid_query(&grid, 1100, 1100, hits, 4) == 0);
+	sc_spatial_grid_remove(&grid, &below);
+	assert(sc_spatial_grid_query(&grid, 150, 150, hits, 4) == 0);
+
+	sc_spatial_grid_finish(&grid);
+	return 0;
+}